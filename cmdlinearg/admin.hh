@@ -0,0 +1,290 @@
+/**
+  @file: admin.hh
+
+  @brief: A small local admin channel for changing the options of a running
+          program, on top of arguments::reloadable (see reload.hh).
+
+The arguments::adminChannel class accepts batches of text commands :
+
+  set <long-name> <value>
+  get <long-name>
+
+one per line. All the 'set's of a batch are applied together through the
+same findArg()/setMe() machinery as the command line and published as one
+new snapshot, or not at all if any of them fails. Readers are never
+blocked. The 'get's are answered after the batch is applied.
+
+example usage :
+  ...
+
+  arguments::reloadable<config> cfg(schema, "/etc/foo.conf", argc, argv);
+  arguments::adminChannel<config> admin(cfg);
+
+  admin.listen("/run/foo.admin");
+
+  ...
+
+and then from a shell :
+
+  printf 'set threads 16\nset cache 1024\nget threads\n' | nc -NU /run/foo.admin
+
+which replies :
+
+  ok
+  threads 16
+
+Each connection to the Unix domain socket is one batch, ended by the
+client closing its side or sending an empty line. A client that goes
+quiet for longer than the timeout given to the constructor, or sends more
+than its batch limit, is dropped without the batch being run, so it can't
+hold up the channel or stop(). Anything else that can
+provide a file descriptor, a FIFO say, can be fed a batch with serve(), and
+run() takes a batch straight from a string.
+
+*/
+
+#ifndef HH_CMDLINEARG_ADMIN_HH
+#define HH_CMDLINEARG_ADMIN_HH
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "reload.hh"
+
+namespace arguments {
+
+template<typename Config, typename Options = options<> >
+struct adminChannel
+  {
+  reloadable<Config, Options> &cfg;
+  std::string path;
+  int fd;
+  std::thread worker;
+  int stopFd[2];
+  std::size_t maxBatch;
+  int timeout;
+
+  /** @param maxBatch  The most bytes a batch may have.
+      @param timeout   Milliseconds to wait for more of a batch, -1 for ever.
+  */
+  adminChannel(reloadable<Config, Options> &_cfg, std::size_t _maxBatch = 65536, int _timeout = 5000)
+    : cfg(_cfg), fd(-1), stopFd{-1, -1}, maxBatch(_maxBatch), timeout(_timeout) {}
+
+  ~adminChannel() { stop(); }
+
+  /** Run one batch of commands, returning the reply text.
+
+      @param batch  Commands, one per line, blank lines and '#' are ignored.
+  */
+  std::string run(std::string batch)
+    {
+    std::vector<std::pair<const char*, const char*> > sets;
+    std::vector<const char*> gets;
+    std::ostringstream reply;
+    char* p = &batch[0];
+    char* end = p + batch.size();
+
+    while (p < end)
+      {
+      char* nl = std::find(p, end, '\n');
+      char* w[3] = {nullptr, nullptr, nullptr};
+      int n = 0;
+
+      *nl = '\0';
+      while (n < 3 && p < nl)
+        {
+        while (p < nl && std::isspace((unsigned char)*p))
+          *p++ = '\0';
+        if (p < nl)
+          w[n++] = p;
+        while (p < nl && (n == 3 || !std::isspace((unsigned char)*p)))
+          ++p;
+        }
+
+      // The value is the rest of the line, less trailing space.
+      for (char* t = nl; n == 3 && t > w[2] && std::isspace((unsigned char)t[-1]); )
+        *--t = '\0';
+
+      p = nl + 1;
+
+      if (n == 0 || w[0][0] == '#')
+        continue;
+
+      if (n == 3 && std::strcmp(w[0], "set") == 0)
+        sets.push_back(std::make_pair(w[1], w[2]));
+      else if (n == 2 && std::strcmp(w[0], "get") == 0)
+        gets.push_back(w[1]);
+      else
+        {
+        reply << "error: bad command '" << w[0] << "'\n";
+        return reply.str();
+        }
+      }
+
+    if (!sets.empty())
+      {
+      errorState e = cfg.set(sets);
+
+      if (e.isOk())
+        reply << "ok\n";
+      else
+        reply << "error: " << e << "\n";
+      }
+
+    for (auto name: gets)
+      {
+      std::string v;
+
+      if (cfg.get(name, v))
+        reply << name << " " << v << "\n";
+      else
+        reply << "error: Unknown Option: '" << name << "'\n";
+      }
+
+    return reply.str();
+    }
+
+  /** Read a batch from in, up to end of file or an empty line, run it and
+      write the reply to out. Gives up, running nothing, if the batch is
+      too long, in goes quiet for too long or stop() is called.
+  */
+  bool serve(int in, int out)
+    {
+    std::string batch;
+    char buf[4096];
+    ssize_t n = 0;
+    pollfd fds[2] = { {in, POLLIN, 0}, {stopFd[0], POLLIN, 0} };
+
+    for (;;)
+      {
+      int p = poll(fds, 2, timeout);
+
+      if (p < 0 && errno == EINTR)
+        continue;
+
+      if (p <= 0 || (fds[1].revents & POLLIN))
+        return false;
+
+      if ( (n = read(in, buf, sizeof(buf))) <= 0 )
+        break;
+
+      batch.append(buf, n);
+      if (batch.size() > maxBatch)
+        {
+        static const char tooLong[] = "error: batch too long\n";
+
+        n = write(out, tooLong, sizeof(tooLong) - 1);
+        return false;
+        }
+
+      if (batch.size() >= 2 && batch.compare(batch.size() - 2, 2, "\n\n") == 0)
+        break;
+      }
+
+    if (n < 0)
+      return false;
+
+    std::string r = run(batch);
+    const char* p = r.data();
+    const char* e = p + r.size();
+
+    while (p < e && (n = write(out, p, e - p)) > 0)
+      p += n;
+
+    return p == e;
+    }
+
+  /** Serve batches on a Unix domain socket at path, from a background
+      thread, one connection at a time. The socket is only accessible to
+      the owner: it's made under umask(077), which briefly applies to the
+      whole process. A stale socket at path is replaced, anything else
+      there is left alone and listen() fails.
+  */
+  bool listen(const std::string &_path)
+    {
+    sockaddr_un addr;
+    struct stat st;
+
+    if (worker.joinable() || _path.size() >= sizeof(addr.sun_path)
+        || (lstat(_path.c_str(), &st) == 0 && !S_ISSOCK(st.st_mode)))
+      return false;
+
+    path = _path;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path.c_str());
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0)
+      unlink(path.c_str());
+
+    mode_t mask = umask(077);
+    bool bound = fd >= 0 && bind(fd, (sockaddr*)&addr, sizeof(addr)) == 0;
+
+    umask(mask);
+
+    if (!bound || chmod(path.c_str(), 0600) != 0 || ::listen(fd, 4) != 0
+        || pipe(stopFd) != 0)
+      {
+      if (fd >= 0)
+        close(fd);
+      fd = -1;
+      return false;
+      }
+
+    worker = std::thread([this]
+      {
+      pollfd fds[2] = { {fd, POLLIN, 0}, {stopFd[0], POLLIN, 0} };
+
+      while (poll(fds, 2, -1) >= 0 && !(fds[1].revents & POLLIN))
+        {
+        int c = accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+
+        if (c >= 0)
+          {
+          serve(c, c);
+          close(c);
+          }
+        }
+      });
+
+    return true;
+    }
+
+  // Stop listening, if we are.
+  void stop()
+    {
+    if (!worker.joinable())
+      return;
+
+    char c = 0;
+    if (write(stopFd[1], &c, 1) == 1)
+      worker.join();
+    else
+      worker.detach();
+
+    close(stopFd[0]);
+    close(stopFd[1]);
+    close(fd);
+    unlink(path.c_str());
+    fd = -1;
+    }
+  };
+
+} // namespace arguments
+
+//HH_CMDLINEARG_ADMIN_HH
+#endif
@@ -0,0 +1,156 @@
+/**
+  @file: async.hh
+
+  @brief: Populate in two phases: the options flagged critical at once, the
+          rest on a background thread.
+
+A service with huge argument lists can't start logging or listen on its
+port until every value has been converted. populateAsync() walks argv
+once, converting the values of options flagged 'critical' as it goes and
+only noting where the others' values are. It returns as soon as the
+critical options, and their defaults, are set. Everything else is
+converted, and the defaults set, on a thread of its own, completing a
+future.
+
+example usage :
+  ...
+
+  arguments::options<> args;
+
+  args.option(port, "p", "port", "Port to listen on", "8080", arguments::critical );
+  args.option(logLevel, "v", "verbosity", "Log level", "1", arguments::critical );
+  args.option(inputs, "i", "input", "Bulk inputs", nullptr );
+  ...
+
+  std::future<arguments::errorState> rest;
+
+  if ( !arguments::populateAsync(args, argc, argv, rest).isOk() )
+    ...
+
+  startLogging(logLevel);
+  listen(port);
+
+  if ( !rest.get().isOk() )   // Now inputs can be used.
+    ...
+
+The first phase reports unknown options, missing values and critical
+values that don't convert, the future the first of the rest, as populate()
+would: values after it are left unconverted and defaults unset. Until the
+future is ready only the critical options' variables may be touched, and
+args, argv and the strings in it must stay put. An observer (see usage.hh)
+is told on the background thread. Build with -pthread.
+
+*/
+
+#ifndef HH_CMDLINEARG_ASYNC_HH
+#define HH_CMDLINEARG_ASYNC_HH
+
+#include <cstring>
+#include <future>
+#include <utility>
+#include <vector>
+
+#include "cmdlinearg.hh"
+
+namespace arguments {
+
+/** Populate the critical options now and the others in the background.
+
+    @param args  The options, all declared.
+    @param argc  Inbound argument count
+    @param argv  Inbound argument vector
+    @param rest  Set to the result of the background phase, or to the first
+                 phase's error if that failed.
+    @return the first error of the first phase, if any.
+*/
+template<typename Options>
+errorState populateAsync(Options &args, int c, const char *argv[],
+                         std::future<errorState> &rest)
+  {
+  typedef typename Options::argObjBase argObjBase;
+  typedef std::vector<std::pair<argObjBase*, const char*> > later_t;
+
+  argSpan span(argv + (c > 0), argv + (c > 0 ? c : 0), 1);
+  errorState r{ok, nullptr, nullptr, nullptr, 0};
+  later_t later;
+
+  argObjBase* defOp = args.findDefault();
+  shard mine;
+
+  span.mine = args.findShard(c, argv, mine);
+
+  for (auto &a: args.options)
+    {
+    a->raw = argObjBase::rawBasis;
+    a->given = false;
+    a->failed = false;
+    }
+
+  auto split = [&later](argObjBase* a, const char* v)
+    {
+    if (a->flags & critical)
+      return Options::noteAndSet(a, v);
+
+    if (a == Options::none())
+      return false;
+
+    a->note(v);
+    later.push_back(std::make_pair(a, v));
+    return true;
+    };
+
+  while (!span.empty() && (r = args.proc(span, defOp, split)).state == ok)
+    {}
+
+  if (r.state == ok)
+    for (auto &a: args.options)
+      if ((a->flags & critical) && a->seen == false && a->d != nullptr
+          && (a->failed = !a->setMe(a->d)) && r.state == ok)
+        r = errorState{invalid, a->l ? a->l : a->s, a->d, a->at, 0};
+
+  if (r.state != ok)
+    {
+    std::promise<errorState> p;
+
+    p.set_value(r);
+    rest = p.get_future();
+    return r;
+    }
+
+  auto convert = [&args, c, argv](later_t vals)
+    {
+    errorState e{ok, nullptr, nullptr, nullptr, 0};
+
+    // As populate(), stop at the first value that doesn't convert.
+    for (auto &v: vals)
+      if ((v.first->failed = !v.first->setMe(v.second)))
+        {
+        e = errorState{invalid, v.first->l ? v.first->l : v.first->s, v.second, v.first->at, 0};
+
+        if (e.op == nullptr)
+          e.op = "default list";
+
+        // Only now find which argument it was (a value may follow a '=').
+        for (int i = 1; i < c && e.arg == 0; ++i)
+          if (v.second >= argv[i] && v.second <= argv[i] + std::strlen(argv[i]))
+            e.arg = i;
+        break;
+        }
+
+    if (e.state == ok)
+      e = args.setDefaults();
+
+    if (args.observer)
+      args.observer->populated(args);
+
+    return e;
+    };
+
+  rest = std::async(std::launch::async, convert, std::move(later));
+  return r;
+  }
+
+} // namespace arguments
+
+//HH_CMDLINEARG_ASYNC_HH
+#endif
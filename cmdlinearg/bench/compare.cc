@@ -0,0 +1,431 @@
+/**
+  @file: compare.cc
+
+  @brief: Benchmark arguments::options against other command line parsers
+          on the same schema and argument corpora.
+
+Build with the CMake option CMDLINEARG_BENCHMARKS=ON, or :
+
+  g++ -O2 -std=c++17 -I.. -o compare compare.cc
+
+and run it with no arguments. For each parser and corpus it prints the
+time and heap allocations per parse, and the peak RSS of a process that
+did nothing else. Each run is in its own forked child so the RSS figures
+don't mix.
+
+The parsers are :
+
+  cmdlinearg         a new options object, declared and populated, per parse.
+  cmdlinearg-reuse   one options object, reset() and populated again.
+  getopt_long        glibc, with the value conversions written out by hand.
+  CLI11, cxxopts     if their headers are found (CLI/CLI.hpp, cxxopts.hpp).
+
+Each can be left out by defining BENCH_<NAME> to 0. cost.sh uses that to
+measure what one parser adds to compile time and binary size.
+
+*/
+
+#ifndef BENCH_CMDLINEARG
+#define BENCH_CMDLINEARG 1
+#endif
+
+#ifndef BENCH_GETOPT
+#define BENCH_GETOPT 1
+#endif
+
+#ifndef BENCH_CLI11
+#if defined(__has_include) && __has_include(<CLI/CLI.hpp>)
+#define BENCH_CLI11 1
+#else
+#define BENCH_CLI11 0
+#endif
+#endif
+
+#ifndef BENCH_CXXOPTS
+#if defined(__has_include) && __has_include(<cxxopts.hpp>)
+#define BENCH_CXXOPTS 1
+#else
+#define BENCH_CXXOPTS 0
+#endif
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if BENCH_CMDLINEARG
+#include "cmdlinearg.hh"
+#endif
+
+#if BENCH_GETOPT
+#include <getopt.h>
+#endif
+
+#if BENCH_CLI11
+#include <CLI/CLI.hpp>
+#endif
+
+#if BENCH_CXXOPTS
+#include <cxxopts.hpp>
+#endif
+
+// Count heap allocations.
+static unsigned long allocations = 0;
+
+void* operator new(std::size_t n)
+  {
+  ++allocations;
+  if (void* p = std::malloc(n ? n : 1))
+    return p;
+  throw std::bad_alloc();
+  }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+// The schema, the same for every parser.
+struct values
+  {
+  int count, depth;
+  float ratio, scale;
+  std::string outfile, mode, host;
+  bool verbose, dryRun, force;
+  std::vector<int> ws;
+  std::vector<std::string> files;
+
+  bool operator==(const values &o) const
+    {
+    return count == o.count && depth == o.depth && ratio == o.ratio && scale == o.scale
+           && outfile == o.outfile && mode == o.mode && host == o.host
+           && verbose == o.verbose && dryRun == o.dryRun && force == o.force
+           && ws == o.ws && files == o.files;
+    }
+  };
+
+struct corpus
+  {
+  const char* name;
+  std::vector<std::string> tokens;
+  };
+
+std::vector<corpus> corpora()
+  {
+  std::vector<corpus> c;
+
+  c.push_back(corpus{"defaults", {}});
+  c.push_back(corpus{"typical", {"-c", "4", "--outfile", "run.dat", "-v", "--mode", "fast",
+                                 "-w", "1", "-w", "2", "in1", "in2"}});
+
+  corpus l{"long", {"--count", "40", "--depth", "12", "--ratio", "0.25", "--scale", "1.5",
+                    "-o", "big.dat", "--mode", "slow", "--host", "example.org",
+                    "-v", "--dry-run", "--force"}};
+
+  for (int i = 0; i < 24; ++i)
+    {
+    l.tokens.push_back("-w");
+    l.tokens.push_back(std::to_string(i));
+    l.tokens.push_back("file" + std::to_string(i));
+    }
+
+  c.push_back(l);
+  return c;
+  }
+
+typedef bool (*parse_f)(int argc, const char** argv, values &v);
+
+#if BENCH_CMDLINEARG
+template<typename Options>
+void declare(Options &args, values &v)
+  {
+  args.option(v.count, "c", "count", "Loops", "13");
+  args.option(v.depth, "d", "depth", "Depth", "8");
+  args.option(v.ratio, "r", "ratio", "Ratio", "0.5");
+  args.option(v.scale, "s", "scale", "Scale", "1");
+  args.option(v.outfile, "o", "outfile", "Output file", "out.dat");
+  args.option(v.mode, "m", "mode", "Mode", "normal");
+  args.option(v.host, nullptr, "host", "Host", "localhost");
+  args.option(v.verbose, "v", "verbose", "Talk more", nullptr);
+  args.option(v.dryRun, "n", "dry-run", "Don't", nullptr);
+  args.option(v.force, "f", "force", "Do anyway", nullptr);
+  args.option(v.ws, "w", "w", "w list", nullptr);
+  args.option(v.files, nullptr, nullptr, "Input files", nullptr);
+  }
+
+bool parseCmdlinearg(int argc, const char** argv, values &v)
+  {
+  arguments::options<> args;
+
+  // Lists append and bools are only ever set, as in parseGetopt().
+  v.verbose = v.dryRun = v.force = false;
+  v.ws.clear();
+  v.files.clear();
+
+  declare(args, v);
+  bool ok = args.populate(argc, argv).isOk();
+
+  for (auto a: args.options)
+    delete a;
+
+  return ok;
+  }
+
+bool parseCmdlineargReuse(int argc, const char** argv, values &v)
+  {
+  static values *bound = nullptr;
+  static arguments::options<> args;
+
+  if (bound != &v)
+    {
+    for (auto a: args.options)
+      delete a;
+    args.options.clear();
+    declare(args, v);
+    bound = &v;
+    }
+
+  for (auto a: args.options)
+    a->reset();
+
+  return args.populate(argc, argv).isOk();
+  }
+#endif
+
+#if BENCH_GETOPT
+bool parseGetopt(int argc, const char** argv, values &v)
+  {
+  static const option longs[] = {
+    {"count", required_argument, nullptr, 'c'},
+    {"depth", required_argument, nullptr, 'd'},
+    {"ratio", required_argument, nullptr, 'r'},
+    {"scale", required_argument, nullptr, 's'},
+    {"outfile", required_argument, nullptr, 'o'},
+    {"mode", required_argument, nullptr, 'm'},
+    {"host", required_argument, nullptr, 'H'},
+    {"verbose", no_argument, nullptr, 'v'},
+    {"dry-run", no_argument, nullptr, 'n'},
+    {"force", no_argument, nullptr, 'f'},
+    {"w", required_argument, nullptr, 'w'},
+    {nullptr, 0, nullptr, 0}
+  };
+
+  v.count = 13; v.depth = 8; v.ratio = 0.5f; v.scale = 1;
+  v.outfile = "out.dat"; v.mode = "normal"; v.host = "localhost";
+  v.verbose = v.dryRun = v.force = false;
+  v.ws.clear();
+  v.files.clear();
+
+  optind = 0;
+  opterr = 0;
+
+  int c;
+  char* e;
+
+  while ((c = getopt_long(argc, const_cast<char**>(argv), "c:d:r:s:o:m:vnfw:", longs, nullptr)) != -1)
+    switch (c)
+      {
+      case 'c': v.count = std::strtol(optarg, &e, 0); if (e == optarg) return false; break;
+      case 'd': v.depth = std::strtol(optarg, &e, 0); if (e == optarg) return false; break;
+      case 'r': v.ratio = std::strtof(optarg, &e); if (e == optarg) return false; break;
+      case 's': v.scale = std::strtof(optarg, &e); if (e == optarg) return false; break;
+      case 'o': v.outfile = optarg; break;
+      case 'm': v.mode = optarg; break;
+      case 'H': v.host = optarg; break;
+      case 'v': v.verbose = true; break;
+      case 'n': v.dryRun = true; break;
+      case 'f': v.force = true; break;
+      case 'w': v.ws.push_back(std::strtol(optarg, &e, 0)); if (e == optarg) return false; break;
+      default: return false;
+      }
+
+  for (int i = optind; i < argc; ++i)
+    v.files.push_back(argv[i]);
+
+  return true;
+  }
+#endif
+
+#if BENCH_CLI11
+bool parseCLI11(int argc, const char** argv, values &v)
+  {
+  CLI::App app;
+
+  v = values{13, 8, 0.5f, 1, "out.dat", "normal", "localhost", false, false, false, {}, {}};
+  app.add_option("-c,--count", v.count, "Loops");
+  app.add_option("-d,--depth", v.depth, "Depth");
+  app.add_option("-r,--ratio", v.ratio, "Ratio");
+  app.add_option("-s,--scale", v.scale, "Scale");
+  app.add_option("-o,--outfile", v.outfile, "Output file");
+  app.add_option("-m,--mode", v.mode, "Mode");
+  app.add_option("--host", v.host, "Host");
+  app.add_flag("-v,--verbose", v.verbose, "Talk more");
+  app.add_flag("-n,--dry-run", v.dryRun, "Don't");
+  app.add_flag("-f,--force", v.force, "Do anyway");
+  app.add_option("-w", v.ws, "w list")->allow_extra_args(false);
+  app.add_option("files", v.files, "Input files");
+
+  try
+    {
+    app.parse(argc, argv);
+    }
+  catch (const CLI::ParseError &)
+    {
+    return false;
+    }
+
+  return true;
+  }
+#endif
+
+#if BENCH_CXXOPTS
+bool parseCxxopts(int argc, const char** argv, values &v)
+  {
+  cxxopts::Options o("bench");
+
+  v = values{13, 8, 0.5f, 1, "out.dat", "normal", "localhost", false, false, false, {}, {}};
+  o.add_options()
+    ("c,count", "Loops", cxxopts::value<int>(v.count)->default_value("13"))
+    ("d,depth", "Depth", cxxopts::value<int>(v.depth)->default_value("8"))
+    ("r,ratio", "Ratio", cxxopts::value<float>(v.ratio)->default_value("0.5"))
+    ("s,scale", "Scale", cxxopts::value<float>(v.scale)->default_value("1"))
+    ("o,outfile", "Output file", cxxopts::value<std::string>(v.outfile)->default_value("out.dat"))
+    ("m,mode", "Mode", cxxopts::value<std::string>(v.mode)->default_value("normal"))
+    ("host", "Host", cxxopts::value<std::string>(v.host)->default_value("localhost"))
+    ("v,verbose", "Talk more", cxxopts::value<bool>(v.verbose))
+    ("n,dry-run", "Don't", cxxopts::value<bool>(v.dryRun))
+    ("f,force", "Do anyway", cxxopts::value<bool>(v.force))
+    ("w", "w list", cxxopts::value<std::vector<int> >(v.ws))
+    ("files", "Input files", cxxopts::value<std::vector<std::string> >(v.files));
+  o.parse_positional({"files"});
+
+  try
+    {
+    o.parse(argc, argv);
+    }
+  catch (const std::exception &)
+    {
+    return false;
+    }
+
+  return true;
+  }
+#endif
+
+struct parser
+  {
+  const char* name;
+  parse_f parse;
+  };
+
+const parser parsers[] = {
+#if BENCH_CMDLINEARG
+  {"cmdlinearg", parseCmdlinearg},
+  {"cmdlinearg-reuse", parseCmdlineargReuse},
+#endif
+#if BENCH_GETOPT
+  {"getopt_long", parseGetopt},
+#endif
+#if BENCH_CLI11
+  {"CLI11", parseCLI11},
+#endif
+#if BENCH_CXXOPTS
+  {"cxxopts", parseCxxopts},
+#endif
+  {nullptr, nullptr}
+};
+
+// Parse c with p until enough time has gone by, in this process.
+void run(const parser &p, const corpus &c, const values *expect)
+  {
+  std::vector<const char*> argv, work;
+  values v = values();
+
+  argv.push_back("bench");
+  for (auto &t: c.tokens)
+    argv.push_back(t.c_str());
+
+  // getopt_long() permutes argv, so every parser gets a fresh copy.
+  work = argv;
+  if (!p.parse((int)work.size(), work.data(), v))
+    {
+    std::printf("%-18s %-10s parse failed\n", p.name, c.name);
+    return;
+    }
+
+  const char* same = (expect == nullptr || v == *expect) ? "" : "  (values differ)";
+  std::chrono::duration<double> took(0);
+  unsigned long n = 0, total = 0, a0 = allocations;
+
+  for (n = 1000; took.count() < 0.2; n *= 2)
+    {
+    auto start = std::chrono::steady_clock::now();
+
+    for (unsigned long i = 0; i < n; ++i)
+      {
+      work = argv;
+      p.parse((int)work.size(), work.data(), v);
+      }
+
+    took = std::chrono::steady_clock::now() - start;
+    total += n;
+    }
+
+  std::printf("%-18s %-10s %10.1f ns %8.1f allocs", p.name, c.name,
+              took.count() * 1e9 / (n / 2), double(allocations - a0) / total);
+  std::printf("%s", same);
+  }
+
+} // namespace
+
+int main()
+  {
+  std::vector<corpus> cs = corpora();
+  std::vector<values> expect(cs.size());
+
+  if (parsers[0].name == nullptr)
+    return 0;
+
+  std::printf("%-18s %-10s %13s %15s %12s\n", "parser", "corpus", "time/parse", "allocs/parse", "peak RSS");
+
+  for (std::size_t i = 0; i < cs.size(); ++i)
+    {
+    std::vector<const char*> argv(1, "bench");
+
+    for (auto &t: cs[i].tokens)
+      argv.push_back(t.c_str());
+    parsers[0].parse((int)argv.size(), argv.data(), expect[i]);
+    }
+
+  for (const parser* p = parsers; p->name; ++p)
+    for (std::size_t i = 0; i < cs.size(); ++i)
+      {
+      std::fflush(stdout);
+
+      pid_t pid = fork();
+
+      if (pid == 0)
+        {
+        run(*p, cs[i], &expect[i]);
+        std::fflush(stdout);
+        _exit(0);
+        }
+
+      int status;
+      rusage ru;
+
+      if (pid < 0 || wait4(pid, &status, 0, &ru) != pid)
+        return 1;
+
+      std::printf(" %8ld kB\n", ru.ru_maxrss);
+      }
+
+  return 0;
+  }
@@ -0,0 +1,51 @@
+#!/bin/sh
+#
+# What each parser adds to the compile time and (stripped) binary size of
+# compare.cc, over the same file with no parser at all.
+#
+#   ./cost.sh [compiler flags...]
+#
+# Uses $CXX (default c++), with -O2 -std=c++17 unless flags are given.
+
+set -e
+
+CXX=${CXX:-c++}
+FLAGS=${*:--O2 -std=c++17}
+DIR=$(cd "$(dirname "$0")" && pwd)
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+PARSERS="CMDLINEARG GETOPT CLI11 CXXOPTS"
+
+# build <parser or none>: prints milliseconds and stripped size.
+build()
+  {
+  defs=
+  for q in $PARSERS; do
+    [ $q = $1 ] && defs="$defs -DBENCH_$q=1" || defs="$defs -DBENCH_$q=0"
+  done
+
+  start=$(date +%s%N)
+  $CXX $FLAGS $defs -I"$DIR/.." -o "$TMP/$1" "$DIR/compare.cc"
+  end=$(date +%s%N)
+  strip "$TMP/$1"
+  echo $(( (end - start) / 1000000 )) $(wc -c < "$TMP/$1")
+  }
+
+set -- $(build none)
+baseTime=$1 baseSize=$2
+
+printf '%-12s %12s %14s\n' parser "compile +ms" "binary +bytes"
+
+for p in $PARSERS
+  do
+  if [ $p = CLI11 ] && ! echo '#include <CLI/CLI.hpp>' | $CXX $FLAGS -x c++ -fsyntax-only - 2>/dev/null; then
+    continue
+  fi
+  if [ $p = CXXOPTS ] && ! echo '#include <cxxopts.hpp>' | $CXX $FLAGS -x c++ -fsyntax-only - 2>/dev/null; then
+    continue
+  fi
+
+  set -- $(build $p)
+  printf '%-12s %12d %14d\n' $p $(($1 - baseTime)) $(($2 - baseSize))
+  done
@@ -0,0 +1,303 @@
+/**
+  @file: startup.cc
+
+  @brief: Measure whole process startup, exec to exit, of small tools
+          built on arguments::options. (Linux only).
+
+Microbenchmarks of populate() miss the dynamic loader, static
+initialisation and page faults, which are most of the cost for a tiny
+tool that's spawned often. This runs each tool given many times with a
+typical command line and reports the latency distribution, from the
+moment the forked child is let go to exec() until it has been reaped.
+
+Build with the CMake option CMDLINEARG_BENCHMARKS=ON, which also builds
+sample tools with 10, 100 and 1000 options (see startup.cmake) and a
+'cmdlinearg_startup_run' target that runs them all :
+
+  ./cmdlinearg_startup [--runs 2000] [--baseline file [--save]] tool...
+
+The command line given to the tools is :
+
+  tool --opt0 7 --opt1 hello --opt2 --opt3 9 in1 in2
+
+Per tool it prints p50, p90 and p99 latency, and the median minor page
+faults. Instructions and cycles are added where perf_event_open() is
+allowed (see /proc/sys/kernel/perf_event_paranoid), counting kernel work
+too if permitted, else user space only, marked 'u'.
+
+With --baseline, the results are compared with those in the file and any
+tool whose p50 or p99 got more than --threshold percent worse is
+reported, with an exit status of 1. The file is written if it doesn't
+exist, or with --save.
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "cmdlinearg.hh"
+
+namespace {
+
+struct counters
+  {
+  int fd[2];
+  bool user;   // Only user space is counted.
+
+  counters() : fd{-1, -1}, user(false) {}
+
+  ~counters() { close(); }
+
+  void close()
+    {
+    for (auto &f: fd)
+      {
+      if (f >= 0)
+        ::close(f);
+      f = -1;
+      }
+    }
+
+  static int open(pid_t pid, std::uint64_t config, bool user)
+    {
+    perf_event_attr a;
+
+    std::memset(&a, 0, sizeof(a));
+    a.size = sizeof(a);
+    a.type = PERF_TYPE_HARDWARE;
+    a.config = config;
+    a.disabled = 1;
+    a.enable_on_exec = 1;
+    a.exclude_hv = 1;
+    a.exclude_kernel = user;
+
+    return (int)syscall(SYS_perf_event_open, &a, pid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    }
+
+  // Count instructions and cycles of pid from its next exec().
+  bool attach(pid_t pid)
+    {
+    for (bool u: {false, true})
+      {
+      fd[0] = open(pid, PERF_COUNT_HW_INSTRUCTIONS, u);
+      fd[1] = open(pid, PERF_COUNT_HW_CPU_CYCLES, u);
+      user = u;
+      if (fd[0] >= 0 && fd[1] >= 0)
+        return true;
+      close();
+      }
+
+    return false;
+    }
+
+  std::uint64_t read(int i)
+    {
+    std::uint64_t v = 0;
+
+    return ::read(fd[i], &v, sizeof(v)) == sizeof(v) ? v : 0;
+    }
+  };
+
+struct result
+  {
+  double p50, p90, p99;   // Microseconds.
+  long minflt;
+  std::uint64_t instructions, cycles;
+  bool counted, user;
+  };
+
+template<typename T>
+T percentile(std::vector<T> v, int pct)
+  {
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, v.size() * pct / 100)];
+  }
+
+// Run tool 'runs' times, false if it couldn't be run or didn't exit 0.
+bool measure(const std::string &tool, int runs, result &r)
+  {
+  const char* argv[] = {tool.c_str(), "--opt0", "7", "--opt1", "hello", "--opt2",
+                        "--opt3", "9", "in1", "in2", nullptr};
+  std::vector<double> took;
+  std::vector<long> faults;
+  std::vector<std::uint64_t> ins, cyc;
+
+  r.counted = true;
+
+  for (int i = 0; i < runs; ++i)
+    {
+    int go[2];
+
+    if (pipe2(go, O_CLOEXEC) != 0)
+      return false;
+
+    pid_t pid = fork();
+
+    if (pid == 0)
+      {
+      char c;
+      int null = open("/dev/null", O_WRONLY);
+
+      dup2(null, 1);
+      dup2(null, 2);
+      ::close(go[1]);
+      if (read(go[0], &c, 1) == 1)
+        execv(argv[0], const_cast<char**>(argv));
+      _exit(127);
+      }
+
+    ::close(go[0]);
+    if (pid < 0)
+      {
+      ::close(go[1]);
+      return false;
+      }
+
+    counters pc;
+
+    r.counted = r.counted && pc.attach(pid);
+    r.user = pc.user;
+
+    int status;
+    rusage ru;
+    auto start = std::chrono::steady_clock::now();
+
+    if (write(go[1], "x", 1) != 1 || wait4(pid, &status, 0, &ru) != pid)
+      return false;
+
+    std::chrono::duration<double, std::micro> t = std::chrono::steady_clock::now() - start;
+    ::close(go[1]);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      return false;
+
+    took.push_back(t.count());
+    faults.push_back(ru.ru_minflt);
+    if (r.counted)
+      {
+      ins.push_back(pc.read(0));
+      cyc.push_back(pc.read(1));
+      }
+    }
+
+  r.p50 = percentile(took, 50);
+  r.p90 = percentile(took, 90);
+  r.p99 = percentile(took, 99);
+  r.minflt = percentile(faults, 50);
+  r.instructions = r.counted ? percentile(ins, 50) : 0;
+  r.cycles = r.counted ? percentile(cyc, 50) : 0;
+
+  return true;
+  }
+
+std::string baseName(const std::string &path)
+  {
+  std::size_t s = path.rfind('/');
+
+  return s == std::string::npos ? path : path.substr(s + 1);
+  }
+
+} // namespace
+
+int main(int argc, const char* argv[])
+  {
+  int runs = 2000;
+  float threshold = 10;
+  std::string baseline;
+  bool save = false;
+  std::vector<std::string> tools;
+
+  arguments::options<> args;
+
+  args.option(runs, "n", "runs", "Runs per tool", "2000" );
+  args.option(baseline, "b", "baseline", "Baseline file to compare with", nullptr );
+  args.option(save, "s", "save", "Write the baseline file, even if it exists", nullptr );
+  args.option(threshold, "t", "threshold", "Percent slower that's a regression", "10" );
+  args.option(tools, nullptr, nullptr, "Tools to run", nullptr );
+
+  if ( args.populateWithHelp(argc, argv, std::cerr,
+          "Usage:\n " + std::string(argv[0]) + " [options] tool...\n" ) )
+    return 2;
+
+  std::map<std::string, result> base;
+  std::ifstream in(baseline);
+  std::string line;
+
+  while (!baseline.empty() && std::getline(in, line))
+    {
+    std::istringstream w(line);
+    std::string name;
+    result b = result();
+
+    if (w >> name >> b.p50 >> b.p99 >> b.minflt)
+      base[name] = b;
+    }
+
+  bool writeBase = !baseline.empty() && (save || base.empty());
+  bool regressed = false;
+  std::ostringstream out;
+
+  std::printf("%-28s %9s %9s %9s %8s %12s %12s\n",
+              "tool", "p50 us", "p90 us", "p99 us", "minflt", "instructions", "cycles");
+
+  for (auto &tool: tools)
+    {
+    result r = result();
+    std::string name = baseName(tool);
+
+    if (!measure(tool, runs > 0 ? runs : 1, r))
+      {
+      std::printf("%-28s failed to run\n", name.c_str());
+      return 2;
+      }
+
+    std::printf("%-28s %9.1f %9.1f %9.1f %8ld", name.c_str(), r.p50, r.p90, r.p99, r.minflt);
+    if (r.counted)
+      std::printf(" %11llu%s %11llu%s", (unsigned long long)r.instructions, r.user ? "u" : " ",
+                  (unsigned long long)r.cycles, r.user ? "u" : " ");
+    else
+      std::printf(" %12s %12s", "-", "-");
+
+    auto b = base.find(name);
+
+    if (!writeBase && b != base.end()
+        && (r.p50 > b->second.p50 * (1 + threshold / 100)
+            || r.p99 > b->second.p99 * (1 + threshold / 100)))
+      {
+      std::printf("  REGRESSION (baseline p50 %.1f, p99 %.1f)", b->second.p50, b->second.p99);
+      regressed = true;
+      }
+
+    std::printf("\n");
+    out << name << " " << r.p50 << " " << r.p99 << " " << r.minflt << "\n";
+    }
+
+  if (writeBase)
+    {
+    std::ofstream f(baseline);
+
+    if (!(f << out.str()))
+      {
+      std::cerr << "Can't write '" << baseline << "'\n";
+      return 2;
+      }
+    }
+
+  return regressed ? 1 : 0;
+  }
@@ -0,0 +1,38 @@
+# Sample tools for the startup harness (bench/startup.cc): a main() that
+# declares n options, populates them and exits. Options cycle through int,
+# string and bool, and are named --opt0, --opt1, ...
+
+function(cmdlinearg_startup_tool n)
+  set(src "${CMAKE_CURRENT_BINARY_DIR}/startup_${n}.cc")
+  set(vars "")
+  set(decls "")
+  math(EXPR last "${n} - 1")
+
+  foreach(i RANGE ${last})
+    math(EXPR k "${i} % 3")
+    if(k EQUAL 0)
+      string(APPEND vars "  int v${i} = 0;\n")
+      set(d "\"${i}\"")
+    elseif(k EQUAL 1)
+      string(APPEND vars "  std::string v${i};\n")
+      set(d "\"name${i}\"")
+    else()
+      string(APPEND vars "  bool v${i} = false;\n")
+      set(d "nullptr")
+    endif()
+    string(APPEND decls "  args.option(v${i}, nullptr, \"opt${i}\", \"Option ${i}\", ${d});\n")
+  endforeach()
+
+  set(code "// Generated by startup.cmake, ${n} options.\n\n#include <iostream>\n#include <string>\n#include <vector>\n\n#include \"cmdlinearg.hh\"\n\nint main(int argc, const char* argv[])\n  {\n  arguments::options<> args;\n  std::vector<std::string> files;\n${vars}\n${decls}  args.option(files, nullptr, nullptr, \"Input files\", nullptr);\n\n  return args.populateWithHelp(argc, argv, std::cerr) ? 1 : 0;\n  }\n")
+
+  # Only rewrite on change, so the tools aren't rebuilt by every configure.
+  if(EXISTS "${src}")
+    file(READ "${src}" old)
+  endif()
+  if(NOT old STREQUAL code)
+    file(WRITE "${src}" "${code}")
+  endif()
+
+  add_executable(cmdlinearg_startup_${n} "${src}")
+  target_link_libraries(cmdlinearg_startup_${n} PRIVATE cmdlinearg)
+endfunction()
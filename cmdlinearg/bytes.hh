@@ -0,0 +1,427 @@
+/**
+  @file: bytes.hh
+
+  @brief: Binary blob option types for cmdlinearg.hh, given on the command
+          line as hex or base64 strings.
+
+A bytes option decodes its value straight into a byte container of the
+caller's choosing (anything with resize() and contiguous storage whose
+elements are a single byte, e.g. vector<unsigned char> or string).
+
+example usage :
+  ...
+
+  arguments::hexBytes<> key;
+  arguments::base64Bytes<std::string> blob;
+
+  args.option(key, "k", "key", "Key as hex (0x prefix optional)", nullptr );
+  args.option(blob, "b", "blob", "Payload as base64", nullptr );
+
+  ...
+
+  ./test -k 0x00ff10ab --blob SGVsbG8=
+
+Later occurrences of an option replace the earlier value. A list of blobs
+can be had with a container of bytes, e.g. vector<hexBytes<>>.
+
+Invalid input is reported as an 'invalid' errorState whose 'at' member
+points at the offending character (or the end of the value when it has
+the wrong length).
+
+The decoders are vectorised with AVX2 or SSSE3 when the running CPU has
+them (picked once, at first use) and fall back to plain scalar code
+otherwise. Define CMDLINEARG_NO_SIMD to build the scalar code only.
+
+*/
+
+#ifndef HH_CMDLINEARG_BYTES_HH
+#define HH_CMDLINEARG_BYTES_HH
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "cmdlinearg.hh"
+
+#if !defined(CMDLINEARG_NO_SIMD) && defined(__GNUC__) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define CMDLINEARG_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace arguments {
+
+enum bytes_e { hexEncoding, base64Encoding };
+
+// A byte container that knows how its value is spelt on the command line.
+template<bytes_e E, typename C = std::vector<unsigned char> >
+struct bytes : public C
+  {
+  static_assert(sizeof(typename C::value_type) == 1,
+                "bytes<> needs a container of single byte elements");
+  using C::C;
+  };
+
+template<typename C = std::vector<unsigned char> >
+using hexBytes = bytes<hexEncoding, C>;
+
+template<typename C = std::vector<unsigned char> >
+using base64Bytes = bytes<base64Encoding, C>;
+
+// Decoders. Each decodes n characters from s into out, which the caller
+// has sized, and returns nullptr on success or the first bad character.
+typedef const char* (*decoder_f)(unsigned char* out, const char* s, std::size_t n);
+
+inline int hexValue(unsigned char c)
+  {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+
+  c |= 0x20;
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+
+  return -1;
+  }
+
+inline const char* hexDecodeScalar(unsigned char* out, const char* s, std::size_t n)
+  {
+  for (std::size_t i = 0; i + 1 < n; i += 2)
+    {
+    int hi = hexValue(s[i]), lo = hexValue(s[i+1]);
+
+    if (hi < 0)
+      return s + i;
+    if (lo < 0)
+      return s + i + 1;
+
+    *out++ = (unsigned char)(hi << 4 | lo);
+    }
+
+  return nullptr;
+  }
+
+inline int base64Value(unsigned char c)
+  {
+  if (c >= 'A' && c <= 'Z')
+    return c - 'A';
+  if (c >= 'a' && c <= 'z')
+    return c - 'a' + 26;
+  if (c >= '0' && c <= '9')
+    return c - '0' + 52;
+  if (c == '+')
+    return 62;
+  if (c == '/')
+    return 63;
+
+  return -1;
+  }
+
+// n excludes any '=' padding, and n % 4 != 1.
+inline const char* base64DecodeScalar(unsigned char* out, const char* s, std::size_t n)
+  {
+  for (std::size_t i = 0; i < n; i += 4)
+    {
+    std::size_t k = (n - i < 4) ? n - i : 4;
+    unsigned long q = 0;
+
+    for (std::size_t j = 0; j < 4; ++j)
+      {
+      int x = (j < k) ? base64Value(s[i+j]) : 0;
+
+      if (x < 0)
+        return s + i + j;
+
+      q = q << 6 | x;
+      }
+
+    for (std::size_t j = 0; j + 1 < k; ++j)
+      *out++ = (unsigned char)(q >> (16 - 8*j));
+    }
+
+  return nullptr;
+  }
+
+#ifdef CMDLINEARG_X86_SIMD
+// Hex: 16 (or 32) characters at a time. Digits and letters are classified
+// with range compares, mapped to nibbles and then pairs are merged with a
+// multiply-add. A block with anything invalid in it is left to the scalar
+// code so that the exact offending character is found.
+__attribute__((target("ssse3")))
+inline const char* hexDecodeSSSE3(unsigned char* out, const char* s, std::size_t n)
+  {
+  const __m128i d_lo = _mm_set1_epi8('0' - 1), d_hi = _mm_set1_epi8('9' + 1);
+  const __m128i a_lo = _mm_set1_epi8('a' - 1), a_hi = _mm_set1_epi8('f' + 1);
+  const __m128i lower = _mm_set1_epi8(0x20);
+  const __m128i d_off = _mm_set1_epi8('0'), a_off = _mm_set1_epi8('a' - 10);
+  const __m128i merge = _mm_set1_epi16(0x0110);
+  std::size_t i = 0;
+
+  for (; i + 16 <= n; i += 16)
+    {
+    __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+    __m128i l = _mm_or_si128(v, lower);
+    __m128i isD = _mm_and_si128(_mm_cmpgt_epi8(v, d_lo), _mm_cmplt_epi8(v, d_hi));
+    __m128i isA = _mm_and_si128(_mm_cmpgt_epi8(l, a_lo), _mm_cmplt_epi8(l, a_hi));
+
+    if (_mm_movemask_epi8(_mm_or_si128(isD, isA)) != 0xFFFF)
+      break;
+
+    __m128i x = _mm_or_si128(_mm_and_si128(isD, _mm_sub_epi8(v, d_off)),
+                             _mm_andnot_si128(isD, _mm_sub_epi8(l, a_off)));
+
+    x = _mm_maddubs_epi16(x, merge);
+    _mm_storel_epi64((__m128i*)(out + i/2), _mm_packus_epi16(x, x));
+    }
+
+  return hexDecodeScalar(out + i/2, s + i, n - i);
+  }
+
+__attribute__((target("avx2")))
+inline const char* hexDecodeAVX2(unsigned char* out, const char* s, std::size_t n)
+  {
+  const __m256i d_lo = _mm256_set1_epi8('0' - 1), d_hi = _mm256_set1_epi8('9' + 1);
+  const __m256i a_lo = _mm256_set1_epi8('a' - 1), a_hi = _mm256_set1_epi8('f' + 1);
+  const __m256i lower = _mm256_set1_epi8(0x20);
+  const __m256i d_off = _mm256_set1_epi8('0'), a_off = _mm256_set1_epi8('a' - 10);
+  const __m256i merge = _mm256_set1_epi16(0x0110);
+  std::size_t i = 0;
+
+  for (; i + 32 <= n; i += 32)
+    {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(s + i));
+    __m256i l = _mm256_or_si256(v, lower);
+    __m256i isD = _mm256_and_si256(_mm256_cmpgt_epi8(v, d_lo), _mm256_cmpgt_epi8(d_hi, v));
+    __m256i isA = _mm256_and_si256(_mm256_cmpgt_epi8(l, a_lo), _mm256_cmpgt_epi8(a_hi, l));
+
+    if (_mm256_movemask_epi8(_mm256_or_si256(isD, isA)) != -1)
+      break;
+
+    __m256i x = _mm256_or_si256(_mm256_and_si256(isD, _mm256_sub_epi8(v, d_off)),
+                                _mm256_andnot_si256(isD, _mm256_sub_epi8(l, a_off)));
+
+    x = _mm256_maddubs_epi16(x, merge);
+    x = _mm256_permute4x64_epi64(_mm256_packus_epi16(x, x), 0x08);
+    _mm_storeu_si128((__m128i*)(out + i/2), _mm256_castsi256_si128(x));
+    }
+
+  return hexDecodeScalar(out + i/2, s + i, n - i);
+  }
+
+// Base64: the nibble lookup method of Mula and Lemire. Each block writes a
+// full vector of output but only advances by 3/4 of its input, so the loops
+// stop early enough that the extra bytes always land inside the output.
+__attribute__((target("ssse3")))
+inline const char* base64DecodeSSSE3(unsigned char* out, const char* s, std::size_t n)
+  {
+  const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                       0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                       0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                         0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i mask_2f = _mm_set1_epi8(0x2f);
+  const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  std::size_t i = 0;
+
+  for (; i + 24 <= n; i += 16)
+    {
+    __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+    __m128i hi_n = _mm_and_si128(_mm_srli_epi32(v, 4), mask_2f);
+    __m128i lo = _mm_shuffle_epi8(lut_lo, _mm_and_si128(v, mask_2f));
+    __m128i hi = _mm_shuffle_epi8(lut_hi, hi_n);
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xFFFF)
+      break;
+
+    __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(v, mask_2f), hi_n));
+
+    v = _mm_add_epi8(v, roll);
+    v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+    v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+    _mm_storeu_si128((__m128i*)(out + i/4*3), _mm_shuffle_epi8(v, pack));
+    }
+
+  return base64DecodeScalar(out + i/4*3, s + i, n - i);
+  }
+
+__attribute__((target("avx2")))
+inline const char* base64DecodeAVX2(unsigned char* out, const char* s, std::size_t n)
+  {
+  const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                          0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                          0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                          0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                          0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                          0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                          0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                            0, 0, 0, 0, 0, 0, 0, 0,
+                                            0, 16, 19, 4, -65, -65, -71, -71,
+                                            0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+  const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  const __m256i join = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+  std::size_t i = 0;
+
+  for (; i + 44 <= n; i += 32)
+    {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(s + i));
+    __m256i hi_n = _mm256_and_si256(_mm256_srli_epi32(v, 4), mask_2f);
+    __m256i lo = _mm256_shuffle_epi8(lut_lo, _mm256_and_si256(v, mask_2f));
+    __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_n);
+
+    if (!_mm256_testz_si256(lo, hi))
+      break;
+
+    __m256i roll = _mm256_shuffle_epi8(lut_roll,
+                       _mm256_add_epi8(_mm256_cmpeq_epi8(v, mask_2f), hi_n));
+
+    v = _mm256_add_epi8(v, roll);
+    v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+    v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+    v = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, pack), join);
+    _mm256_storeu_si256((__m256i*)(out + i/4*3), v);
+    }
+
+  return base64DecodeSSSE3(out + i/4*3, s + i, n - i);
+  }
+#endif
+
+// Pick the best decoder for this CPU.
+inline decoder_f pickDecoder(decoder_f scalar, decoder_f sse, decoder_f avx2)
+  {
+#ifdef CMDLINEARG_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return avx2;
+  if (__builtin_cpu_supports("ssse3"))
+    return sse;
+#else
+  (void)sse; (void)avx2;
+#endif
+  return scalar;
+  }
+
+inline const char* hexDecode(unsigned char* out, const char* s, std::size_t n)
+  {
+#ifdef CMDLINEARG_X86_SIMD
+  static const decoder_f f = pickDecoder(hexDecodeScalar, hexDecodeSSSE3, hexDecodeAVX2);
+#else
+  static const decoder_f f = hexDecodeScalar;
+#endif
+  return f(out, s, n);
+  }
+
+inline const char* base64Decode(unsigned char* out, const char* s, std::size_t n)
+  {
+#ifdef CMDLINEARG_X86_SIMD
+  static const decoder_f f = pickDecoder(base64DecodeScalar, base64DecodeSSSE3,
+                                         base64DecodeAVX2);
+#else
+  static const decoder_f f = base64DecodeScalar;
+#endif
+  return f(out, s, n);
+  }
+
+template<typename C>
+unsigned char* bytePtr(C &v)
+  {
+  return v.empty() ? nullptr : reinterpret_cast<unsigned char*>(&v[0]);
+  }
+
+// Conversion from the command line string.
+template<typename C>
+bool fromString(bytes<hexEncoding, C> &v, const char* s, const char* &at)
+  {
+  if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))
+    s += 2;
+
+  std::size_t n = std::strlen(s);
+
+  v.clear();
+  if (n % 2)
+    {
+    at = s + n;
+    return false;
+    }
+
+  v.resize(n / 2);
+  if ( (at = hexDecode(bytePtr(v), s, n)) )
+    v.clear();
+
+  return at == nullptr;
+  }
+
+template<typename C>
+bool fromString(bytes<base64Encoding, C> &v, const char* s, const char* &at)
+  {
+  std::size_t n = std::strlen(s), pad = 0;
+
+  while (pad < 2 && n > 0 && s[n-1] == '=')
+    --n, ++pad;
+
+  v.clear();
+  if (n % 4 == 1 || (pad && (n + pad) % 4))
+    {
+    at = s + n;
+    return false;
+    }
+
+  v.resize(n / 4 * 3 + (n % 4 ? n % 4 - 1 : 0));
+  if ( (at = base64Decode(bytePtr(v), s, n)) )
+    v.clear();
+
+  return at == nullptr;
+  }
+
+// And back again.
+template<typename C>
+void toString(std::string &out, const bytes<hexEncoding, C> &v)
+  {
+  static const char digits[] = "0123456789abcdef";
+
+  for (unsigned char c: v)
+    {
+    out.push_back(digits[c >> 4]);
+    out.push_back(digits[c & 15]);
+    }
+  }
+
+template<typename C>
+void toString(std::string &out, const bytes<base64Encoding, C> &v)
+  {
+  static const char digits[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::size_t n = v.size(), i = 0;
+
+  for (; i < n; i += 3)
+    {
+    unsigned long q = (unsigned long)(unsigned char)v[i] << 16;
+
+    if (i + 1 < n)
+      q |= (unsigned long)(unsigned char)v[i+1] << 8;
+    if (i + 2 < n)
+      q |= (unsigned char)v[i+2];
+
+    out.push_back(digits[q >> 18]);
+    out.push_back(digits[q >> 12 & 63]);
+    out.push_back(i + 1 < n ? digits[q >> 6 & 63] : '=');
+    out.push_back(i + 2 < n ? digits[q & 63] : '=');
+    }
+  }
+
+template<bytes_e E, typename C>
+bool fromString(bytes<E, C> &v, const char* s)
+  {
+  const char* at;
+  return fromString(v, s, at);
+  }
+
+} // namespace arguments
+
+//HH_CMDLINEARG_BYTES_HH
+#endif
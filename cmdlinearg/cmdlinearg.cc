@@ -0,0 +1,25 @@
+/**
+  @file: cmdlinearg.cc
+
+  @brief: The compiled part of the cmdlinearg library, explicit
+          instantiations of options<> for the built-in types.
+
+*/
+
+#include <ostream>
+
+#include "cmdlinearg.hh"
+
+namespace arguments {
+
+#define CMDLINEARG_INSTANTIATE(T) \
+  template struct options<>::argObj<T>; \
+  template int options<>::option<T>(T&, const char*, const char*, \
+                                    const char*, const char*, unsigned);
+
+template struct options<>;
+template bool options<>::populateWithHelp<std::ostream>(int, const char*[],
+                                        std::ostream&, const std::string);
+CMDLINEARG_BUILTIN_TYPES(CMDLINEARG_INSTANTIATE)
+
+} // namespace arguments
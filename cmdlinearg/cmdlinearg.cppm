@@ -0,0 +1,55 @@
+/**
+  @file: cmdlinearg.cppm
+
+  @brief: C++20 module interface for cmdlinearg.hh.
+
+example usage :
+
+  import cmdlinearg;
+
+  arguments::options<> args;
+  ...
+
+*/
+
+module;
+
+#include "cmdlinearg.hh"
+#include "fingerprint.hh"
+
+export module cmdlinearg;
+
+export namespace arguments {
+
+using arguments::options;
+using arguments::errorState;
+using arguments::errorstate_e;
+using arguments::ok;
+using arguments::invalid;
+using arguments::unknown;
+using arguments::missing;
+using arguments::clash;
+using arguments::optionflag_e;
+using arguments::nonSemantic;
+using arguments::critical;
+using arguments::memoize;
+using arguments::keepRaw;
+using arguments::hash128;
+using arguments::shard;
+using arguments::fromString;
+using arguments::toString;
+using arguments::valueVisitor;
+using arguments::visitValue;
+using arguments::fingerprint;
+using arguments::operator<<;
+using arguments::inRange;
+using arguments::oneOf;
+using arguments::lengthIn;
+using arguments::atMost;
+using arguments::satisfies;
+#ifdef __cpp_lib_memory_resource
+using arguments::useResource;
+using arguments::populate;
+#endif
+
+} // namespace arguments
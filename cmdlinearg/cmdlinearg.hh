@@ -55,6 +55,68 @@ populateWithHelp(). This adds the help option '-h' and some default boiler
 plate to produce reasonable output. It calls the more flexible populate()
 member function. See the specific the functions for details.
 
+The help can be narrowed with --help=<pattern> (matching names and help
+text) or --help-group=<name> (e.g. 'db' for --db.pool.size and the like).
+It's formatted and indexed once, then written in one go.
+
+The reverse, turning the options back into a command line (to re-launch a
+worker with the same settings, say), is done by toArgv(). A stable hash of
+the effective values, for cache keys, is given by fingerprint() from
+cmdlinearg/fingerprint.hh.
+
+Libraries that want to own their options can declare them where they're
+used with CMDLINEARG_FLAG() from cmdlinearg/registry.hh, main() then adds
+them all with addRegistered(). Options described by a constexpr table in
+cmdlinearg/schema.hh have duplicate names and bad defaults caught at
+compile time.
+
+The header can be used on its own. For larger programs CMakeLists.txt also
+has cmdlinearg_compiled, a library with options<> already instantiated for
+the built-in types (see CMDLINEARG_BUILTIN_TYPES at the end of this file),
+and, with -DCMDLINEARG_MODULE=ON, a C++20 module: 'import cmdlinearg;'.
+
+Which options are really used, across all runs of a program, can be
+counted in a shared file by attaching the usageCounters from
+cmdlinearg/usage.hh.
+
+Workers that each take their share of one long list of positional
+values can declare a shardOption() (--shard 3/8, say), and every way of
+populating drops the values of other shards as it reads them.
+
+Range checks and the like can be given to option() (inRange(), oneOf(),
+lengthIn(), atMost(), satisfies()), and are applied to each value as it's
+converted, rather than in another pass over the results afterwards. A
+value that fails is not kept, in overlays (see overlay.hh) too.
+
+In C++17, options can also be std::pmr strings and lists. Given a memory
+resource, populate(args, resource, argc, argv) has them allocate all
+their values there, a per request arena say, which can then be dropped
+in one go (see useResource()).
+
+Options whose values repeat a lot (generated command lines, say) can be
+flagged memoize, repeated values are then copied from a small cache of
+the last conversions rather than converted again.
+
+Command strings, rather than argument vectors, can be parsed with
+populateLine(), which splits them shell style in place.
+
+Plugins loaded after the command line was parsed can bring options of
+their own: populateKnown() sets aside what it doesn't recognise, each
+plugin declares its options with addOptions(), which refuses names that
+are already taken, and populateRest() parses just what was set aside.
+
+Services that need a few options (port, log level) before converting
+huge argument lists can flag those critical and use populateAsync() from
+cmdlinearg/async.hh, which converts the rest on a background thread.
+
+Hierarchical names, such as --db.pool.size, can be declared through an
+optionTree from cmdlinearg/tree.hh. It finds them a segment at a time and
+can list, reset, dump or set a whole group, e.g. everything under 'db'.
+
+Programs that parse updated command lines again and again (from an admin
+channel, say) can use repopulate(), which only re-converts the options
+whose values actually changed and reports which ones those were.
+
 By default short options will match if the first part of the argument
 string matches and will pass the remainder of the string on as value.
 Long options much match completely (up to a delimiter).
@@ -77,11 +139,25 @@ For now the understood base types are : bool, int, float, string. Which, except
 
 The understood container types are any that have a push_back() function.
 
+Binary blobs given as hex or base64 strings can be decoded straight into a
+byte container with the types in cmdlinearg/bytes.hh.
+
 Additional types can be added by implementing :
 
   static bool fromString(TYPE &v, const char* s)
 
-for the type TYPE, returning true on success.
+for the type TYPE, returning true on success. Types that can tell where a
+value went wrong may instead implement :
+
+  static bool fromString(TYPE &v, const char* s, const char* &at)
+
+setting 'at' to the offending character, which is reported in errorState.
+To be able to read a value back as a string (see reloadable::get()) also
+implement :
+
+  static void toString(std::string &out, const TYPE &v)
+
+appending the value as it would be given on the command line.
 
 
 TODO:
@@ -127,34 +203,52 @@ TODO:
 #ifndef HH_CMDLINEARG_HH
 #define HH_CMDLINEARG_HH
 
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <forward_list>
+#include <initializer_list>
+#include <iosfwd>
+#include <iterator>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <algorithm>
+#include <new>
+
+#if __cplusplus >= 201703L
+#include <charconv>
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
+#endif
 
 namespace arguments {
 // Single string conversion types: int, bool, string.
 
-bool fromString(std::string &v, const char* s)
+inline bool fromString(std::string &v, const char* s)
    {
    v = std::string(s);
    return true;
    }
 
-bool fromString(int &v,const char* s)
+inline bool fromString(int &v,const char* s)
    {
    char* r;
    v = std::strtol(s, &r, 0);
    return (s != r);
    }
 
-bool fromString(float &v,const char* s)
+inline bool fromString(float &v,const char* s)
    {
    char* r;
    v = std::strtof(s, &r);
    return (s != r);
    }
 
-bool fromString(bool &v, const char* _s)
+inline bool fromString(bool &v, const char* _s)
   {
   std::string s(_s);
   std::transform(s.begin(), s.end(), s.begin(), ::tolower);
@@ -175,261 +269,1859 @@ bool fromString(V<T, Ps...> &v, const char* s)
   if ( (r = fromString(x, s)) )
     v.push_back(x);
 
-  return r;
-  }
+  return r;
+  }
+
+#ifdef __cpp_lib_memory_resource
+// std::pmr strings and lists convert into their own memory resource, list
+// elements are constructed in place so they use it too.
+inline bool fromString(std::pmr::string &v, const char* s)
+  {
+  v.assign(s);
+  return true;
+  }
+
+template <typename T, template <typename,typename> class V>
+bool fromString(V<T, std::pmr::polymorphic_allocator<T> > &v, const char* s)
+  {
+  v.emplace_back();
+
+  if (fromString(v.back(), s))
+    return true;
+
+  v.pop_back();
+  return false;
+  }
+#endif
+
+// Conversion that can also say where in the string it went wrong. Types that
+// can pinpoint the offending character overload this and set 'at'.
+template<typename T>
+bool fromString(T &v, const char* s, const char* &at)
+  {
+  at = nullptr;
+  return fromString(v, s);
+  }
+
+// The reverse: append the value as it would be given on the command line.
+inline void toString(std::string &out, const std::string &v)
+  {
+  out += v;
+  }
+
+inline void toString(std::string &out, int v)
+  {
+  char b[16];
+#ifdef __cpp_lib_to_chars
+  out.append(b, std::to_chars(b, b + sizeof(b), v).ptr - b);
+#else
+  out.append(b, std::snprintf(b, sizeof(b), "%d", v));
+#endif
+  }
+
+inline void toString(std::string &out, float v)
+  {
+  char b[32];
+#ifdef __cpp_lib_to_chars
+  out.append(b, std::to_chars(b, b + sizeof(b), v).ptr - b);
+#else
+  out.append(b, std::snprintf(b, sizeof(b), "%.9g", v));
+#endif
+  }
+
+inline void toString(std::string &out, bool v)
+  {
+  out += v ? "true" : "false";
+  }
+
+// Append every value held, each followed by a '\0', returning how many.
+// Lists give one per element, types without a toString() give none.
+template<typename T>
+auto putValue(std::string &out, const T &v, int) -> decltype(toString(out, v), int())
+  {
+  toString(out, v);
+  out.push_back('\0');
+  return 1;
+  }
+
+template<typename T>
+int putValue(std::string &, const T &, long)
+  {
+  return 0;
+  }
+
+template<typename T>
+int putValues(std::string &out, const T &v)
+  {
+  return putValue(out, v, 0);
+  }
+
+// Equality where the type has it, otherwise never equal.
+template<typename T>
+auto sameValue(const T &a, const T &b, int) -> decltype(bool(a == b))
+  {
+  return a == b;
+  }
+
+template<typename T>
+bool sameValue(const T &, const T &, long)
+  {
+  return false;
+  }
+
+// Lists compare element by element, so those of types without equality
+// still build.
+template <typename T, template <typename,typename...> class V, typename... Ps>
+bool sameValue(const V<T, Ps...> &a, const V<T, Ps...> &b, int)
+  {
+  auto x = a.begin();
+  auto y = b.begin();
+
+  for (; x != a.end() && y != b.end(); ++x, ++y)
+    if (!sameValue<T>(*x, *y, 0))
+      return false;
+
+  return x == a.end() && y == b.end();
+  }
+
+inline bool sameValue(const std::string &a, const std::string &b, int)
+  {
+  return a == b;
+  }
+
+inline int putValues(std::string &out, const std::string &v)
+  {
+  out.append(v.c_str(), v.size() + 1);
+  return 1;
+  }
+
+#ifdef __cpp_lib_memory_resource
+inline int putValues(std::string &out, const std::pmr::string &v)
+  {
+  out.append(v.c_str(), v.size() + 1);
+  return 1;
+  }
+#endif
+
+template <typename T, template <typename,typename...> class V, typename... Ps>
+int putValues(std::string &out, const V<T, Ps...> &v)
+  {
+  int n = 0;
+
+  for (const auto &x: v)
+    n += putValues(out, x);
+
+  return n;
+  }
+
+// Whether a type's values can be written by toString(), see putValues().
+template<typename T>
+auto hasToString(const T &v, int) -> decltype(toString(std::declval<std::string&>(), v), std::true_type());
+
+template<typename T>
+std::false_type hasToString(const T &, long);
+
+inline std::true_type hasToString(const std::string &, int);
+
+template <typename T, template <typename,typename...> class V, typename... Ps>
+auto hasToString(const V<T, Ps...> &, int) -> decltype(hasToString(std::declval<const T&>(), 0));
+
+// What the numbers given to a valueVisitor are.
+enum valueelem_e { noElem = 0, signedElem, unsignedElem, floatElem, boolElem };
+
+template<typename T>
+std::uint16_t valueElem()
+  {
+  return std::is_same<T, bool>::value        ? boolElem
+       : std::is_floating_point<T>::value    ? floatElem
+       : std::is_signed<T>::value            ? signedElem
+       : std::is_integral<T>::value          ? unsignedElem : noElem;
+  }
+
+// Is shown an option's value in a typed form, by argObjBase::visitMe(), for
+// whatever wants it other than as strings (shared.hh lays values out for
+// other processes, say). Numbers are given in memory, elem a valueelem_e
+// and size that of each one.
+struct valueVisitor
+  {
+  virtual void number(const void* p, std::uint16_t elem, std::uint32_t size) = 0;
+  virtual void numbers(const void* p, std::size_t n, std::uint16_t elem, std::uint32_t size) = 0;
+  virtual void string(const char* s, std::size_t n) = 0;
+
+  // n strings one after the other, '\0' terminated, from putValues().
+  virtual void strings(const std::string &s, std::size_t n) = 0;
+
+  // A value of a type with no typed or string form.
+  virtual void opaque() = 0;
+
+  virtual ~valueVisitor() {};
+  };
+
+// Types can have a visitValue() of their own, found by ADL, those without
+// are shown as their strings.
+inline void visitValue(valueVisitor &w, int v)   { w.number(&v, signedElem, sizeof(v)); }
+inline void visitValue(valueVisitor &w, float v) { w.number(&v, floatElem, sizeof(v)); }
+inline void visitValue(valueVisitor &w, bool v)  { w.number(&v, boolElem, sizeof(v)); }
+
+inline void visitValue(valueVisitor &w, const std::string &v)
+  {
+  w.string(v.data(), v.size());
+  }
+
+#ifdef __cpp_lib_memory_resource
+inline void visitValue(valueVisitor &w, const std::pmr::string &v)
+  {
+  w.string(v.data(), v.size());
+  }
+#endif
+
+// Lists of numbers are shown as arrays, lists of anything else as strings.
+template<typename L>
+void visitList(valueVisitor &w, const L &v, std::true_type)
+  {
+  typedef typename L::value_type T;
+  std::string buf(v.size() * sizeof(T), '\0');
+  std::size_t i = 0;
+
+  for (T x: v)
+    std::memcpy(&buf[sizeof(T) * i++], &x, sizeof(T));
+
+  w.numbers(buf.data(), i, valueElem<T>(), sizeof(T));
+  }
+
+template<typename L>
+void visitList(valueVisitor &w, const L &v, std::false_type)
+  {
+  std::string s;
+  int n = putValues(s, v);
+
+  w.strings(s, n);
+  }
+
+template <typename T, template <typename,typename...> class V, typename... Ps>
+void visitValue(valueVisitor &w, const V<T, Ps...> &v)
+  {
+  visitList(w, v, std::is_arithmetic<T>());
+  }
+
+template<typename T>
+void visitString(valueVisitor &w, const T &v, std::true_type)
+  {
+  std::string s;
+  int n = putValues(s, v);
+
+  w.strings(s, n);
+  }
+
+template<typename T>
+void visitString(valueVisitor &w, const T &, std::false_type)
+  {
+  w.opaque();
+  }
+
+template<typename T>
+auto visitTyped(valueVisitor &w, const T &v, int) -> decltype(visitValue(w, v), void())
+  {
+  visitValue(w, v);
+  }
+
+template<typename T>
+void visitTyped(valueVisitor &w, const T &v, long)
+  {
+  visitString(w, v, decltype(hasToString(v, 0))());
+  }
+
+// Whether visitTyped() shows more than opaque(). Options of types it
+// doesn't are flagged keepRaw, the strings given being all there is to
+// tell their values apart by.
+template<typename T>
+auto visitsTyped(const T &v, int) -> decltype(visitValue(std::declval<valueVisitor&>(), v),
+                                              std::true_type());
+
+template<typename T>
+auto visitsTyped(const T &v, long) -> decltype(hasToString(v, 0));
+
+// A small direct mapped cache of conversions, keyed on the raw string, for
+// options flagged memoize. Only successful conversions are kept.
+struct memoBase
+  {
+  virtual ~memoBase() {};
+  };
+
+template<typename T>
+struct memoTable : public memoBase
+  {
+  static const int slots = 32;
+
+  struct entry
+    {
+    bool full = false;
+    std::uint64_t h;
+    std::string raw;
+    T v;
+    };
+
+  entry slot[slots];
+
+  bool get(T &v, const char* s, const char* &at)
+    {
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    const char* e = s;
+
+    for (; *e; ++e)
+      h = (h ^ (unsigned char)*e) * 0x100000001b3ULL;
+
+    entry &x = slot[h % slots];
+    std::size_t n = e - s;
+
+    if (x.full && x.h == h && x.raw.size() == n && std::memcmp(x.raw.data(), s, n) == 0)
+      {
+      v = x.v;
+      at = nullptr;
+      return true;
+      }
+
+    if (!fromString(v, s, at))
+      return false;
+
+    x.full = true;
+    x.h = h;
+    x.raw.assign(s, n);
+    x.v = v;
+    return true;
+    }
+  };
+
+// fromString() through a memo table, made on first use. Lists keep the
+// conversions of their elements.
+template<typename T>
+bool memoFromString(T &v, const char* s, const char* &at, memoBase* &m)
+  {
+  if (m == nullptr)
+    m = new memoTable<T>();
+
+  return static_cast<memoTable<T>*>(m)->get(v, s, at);
+  }
+
+inline bool memoFromString(std::string &v, const char* s, const char* &at, memoBase* &m)
+  {
+  return memoFromString<std::string>(v, s, at, m);
+  }
+
+#ifdef __cpp_lib_memory_resource
+inline bool memoFromString(std::pmr::string &v, const char* s, const char* &at, memoBase* &m)
+  {
+  return memoFromString<std::pmr::string>(v, s, at, m);
+  }
+#endif
+
+// Re-create a std::pmr string or list, empty, on memory resource r (a
+// std::pmr::memory_resource*), see useResource(). Other types are left be,
+// returning false.
+template<typename T>
+bool rebindValue(T &, void*, long)
+  {
+  return false;
+  }
+
+#ifdef __cpp_lib_memory_resource
+template<typename T>
+auto rebindValue(T &v, void* r, int)
+  -> typename std::enable_if<std::is_same<typename T::allocator_type,
+                             std::pmr::polymorphic_allocator<typename T::value_type> >::value, bool>::type
+  {
+  v.~T();
+  new (&v) T(static_cast<std::pmr::memory_resource*>(r));
+  return true;
+  }
+#endif
+
+template <typename T, template <typename,typename...> class V, typename... Ps>
+bool memoFromString(V<T, Ps...> &v, const char* s, const char* &at, memoBase* &m)
+  {
+  T x;
+  bool r;
+
+  if ( (r = memoFromString(x, s, at, m)) )
+    v.push_back(x);
+
+  return r;
+  }
+
+// Checks on values as they're converted, see option(). Each is called with
+// the value just converted (the new element of a list) and the number of
+// values held (the list's size, else 1).
+template<typename N>
+struct rangeCheck
+  {
+  N lo, hi;
+
+  template<typename E>
+  bool operator()(const E &v, std::size_t) const { return !(v < lo) && !(hi < v); }
+  };
+
+template<typename N>
+struct setCheck
+  {
+  std::vector<N> allowed;
+
+  template<typename E>
+  bool operator()(const E &v, std::size_t) const
+    {
+    for (auto &x: allowed)
+      if (v == x)
+        return true;
+
+    return false;
+    }
+  };
+
+struct lengthCheck
+  {
+  std::size_t lo, hi;
+
+  template<typename E>
+  bool operator()(const E &v, std::size_t) const { return v.size() >= lo && v.size() <= hi; }
+  };
+
+struct countCheck
+  {
+  std::size_t most;
+
+  template<typename E>
+  bool operator()(const E &, std::size_t n) const { return n <= most; }
+  };
+
+template<typename P>
+struct predicateCheck
+  {
+  P p;
+
+  template<typename E>
+  bool operator()(const E &v, std::size_t) const { return p(v); }
+  };
+
+// Value in [lo, hi].
+template<typename N>
+rangeCheck<N> inRange(N lo, N hi)                    { return rangeCheck<N>{lo, hi}; }
+
+// Value one of those given (i.e. oneOf({"fast", "small"})).
+template<typename N>
+setCheck<N> oneOf(std::initializer_list<N> allowed)  { return setCheck<N>{allowed}; }
+
+// String (or other sized value) length in [lo, hi].
+inline lengthCheck lengthIn(std::size_t lo, std::size_t hi) { return lengthCheck{lo, hi}; }
+
+// No more than most values in a list.
+inline countCheck atMost(std::size_t most)           { return countCheck{most}; }
+
+// p(value) is true.
+template<typename P>
+predicateCheck<P> satisfies(P p)                     { return predicateCheck<P>{p}; }
+
+// All of the checks given to option().
+template<typename... Cs>
+struct allOf
+  {
+  template<typename E>
+  bool operator()(const E &, std::size_t) const { return true; }
+  };
+
+template<typename C, typename... Cs>
+struct allOf<C, Cs...>
+  {
+  C first;
+  allOf<Cs...> rest;
+
+  allOf(C c, Cs... cs) : first(c), rest(cs...) {}
+
+  template<typename E>
+  bool operator()(const E &v, std::size_t n) const { return first(v, n) && rest(v, n); }
+  };
+
+// The value just converted, how many are held, and dropping the last, for
+// lists and single values.
+template<typename T>
+const T& lastValue(const T &v)                       { return v; }
+
+inline const std::string& lastValue(const std::string &v) { return v; }
+
+template <typename T, template <typename,typename...> class V, typename... Ps>
+typename V<T, Ps...>::const_reference lastValue(const V<T, Ps...> &v) { return v.back(); }
+
+template<typename T>
+std::size_t valueCount(const T &)                    { return 1; }
+
+inline std::size_t valueCount(const std::string &)   { return 1; }
+
+template <typename T, template <typename,typename...> class V, typename... Ps>
+std::size_t valueCount(const V<T, Ps...> &v)         { return v.size(); }
+
+template<typename T>
+bool isList(const T &)                               { return false; }
+
+inline bool isList(const std::string &)              { return false; }
+
+template <typename T, template <typename,typename...> class V, typename... Ps>
+bool isList(const V<T, Ps...> &)                     { return true; }
+
+template<typename T>
+void dropLast(T &)                                   {}
+
+inline void dropLast(std::string &)                  {}
+
+template <typename T, template <typename,typename...> class V, typename... Ps>
+void dropLast(V<T, Ps...> &v)                        { v.pop_back(); }
+
+#ifdef __cpp_lib_memory_resource
+inline const std::pmr::string& lastValue(const std::pmr::string &v) { return v; }
+inline std::size_t valueCount(const std::pmr::string &)             { return 1; }
+inline bool isList(const std::pmr::string &)                         { return false; }
+inline void dropLast(std::pmr::string &)                            {}
+#endif
+
+// Which share of the positional values a worker keeps, given as 'i/n' for
+// every n'th value from the i'th (from 0), or 'i/n:hash' for those whose
+// hash, modulo n, is i. See options::shardOption().
+struct shard
+  {
+  long i, n;
+  bool byHash;
+
+  bool keep(const char* v, long nth) const
+    {
+    if (!byHash)
+      return nth % n == i;
+
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (; *v; ++v)
+      h = (h ^ (unsigned char)*v) * 0x100000001b3ULL;
+
+    return (long)(h % (std::uint64_t)n) == i;
+    }
+
+  bool operator==(const shard &o) const
+    {
+    return i == o.i && n == o.n && byHash == o.byHash;
+    }
+  };
+
+inline bool fromString(shard &v, const char* s)
+  {
+  char* e;
+  long i = std::strtol(s, &e, 10);
+
+  if (e == s || *e != '/')
+    return false;
+
+  const char* t = e + 1;
+  long n = std::strtol(t, &e, 10);
+
+  if (e == t || i < 0 || n < 1 || i >= n || (*e != '\0' && std::strcmp(e, ":hash") != 0))
+    return false;
+
+  v = shard{i, n, *e != '\0'};
+  return true;
+  }
+
+inline void toString(std::string &out, const shard &v)
+  {
+  out += std::to_string(v.i) + "/" + std::to_string(v.n) + (v.byHash ? ":hash" : "");
+  }
+
+// Trait that maps a type to the number of arguments it'll consume.
+template<typename T> struct number_of_arguments         { enum { n = 1 } ; };
+template<>           struct number_of_arguments<bool>   { enum { n = 0 } ; };
+
+// A --help option, given alone or with a pattern (--help=pattern).
+struct helpRequest
+  {
+  bool on;
+  std::string pattern;
+  };
+
+template<>           struct number_of_arguments<helpRequest> { enum { n = 0 } ; };
+
+inline bool fromString(helpRequest &v, const char* s)
+  {
+  v.on = true;
+  v.pattern = std::strcmp(s, "true") == 0 ? "" : s;
+  return true;
+  }
+
+struct argStrings
+  {
+  const char *s, *l, *h, *d;
+  };
+
+// A cursor over an argument vector. It has room to push back the one value
+// that can be split off the end of an option (as in -w=4). 'first' is the
+// position of the first argument, as reported in errorState.
+struct argSpan
+  {
+  const char **b, **p, **e;
+  const char *pushed;
+  int first;
+  const shard* mine;   // The shard of positional values to keep, if set.
+  long nth;            // Positional values so far.
+
+  argSpan(const char **_p, const char **_e, int _first)
+    : b(_p), p(_p), e(_e), pushed(nullptr), first(_first), mine(nullptr), nth(0) {};
+
+  // Is positional value v one to keep? Counts it.
+  bool keeps(const char* v)  { return mine == nullptr || mine->keep(v, nth++); }
+
+  bool empty() const         { return pushed == nullptr && p == e; }
+  const char* front() const  { return pushed ? pushed : *p; }
+  void push_front(const char* s) { pushed = s; }
+
+  // Position of the front argument (a pushed value belongs to the last).
+  int pos() const            { return first + int(p - b) - (pushed ? 1 : 0); }
+
+  void pop_front()
+    {
+    if (pushed)
+      pushed = nullptr;
+    else
+      ++p;
+    }
+  };
+
+/** Split a command string into words as the shell would, in place: words
+    are separated by white space, quotes and backslashes work as in sh,
+    and nothing is expanded. Each word is '\0' terminated where it ends, so
+    s[n] must be writable too (as the terminator of a C or std::string).
+
+    @param s      The command string, overwritten.
+    @param n      Its length.
+    @param words  Filled with pointers to the words in s.
+    @return false if a quote isn't closed.
+*/
+inline bool splitWords(char* s, std::size_t n, std::vector<const char*> &words)
+  {
+  char* e = s + n;
+  char* w = s;
+
+  words.clear();
+
+  for (char* r = s; ; )
+    {
+    while (r < e && (*r == ' ' || *r == '\t' || *r == '\n'))
+      ++r;
+
+    if (r == e)
+      return true;
+
+    char q = 0;
+
+    words.push_back(w);
+
+    for (; r < e && (q || !(*r == ' ' || *r == '\t' || *r == '\n')); ++r)
+      if (q == '\'')
+        {
+        if (*r == '\'')
+          q = 0;
+        else
+          *w++ = *r;
+        }
+      else if (*r == '\\' && r + 1 < e && (q == 0 || std::strchr("\\\"$`\n", r[1])))
+        {
+        if (*++r != '\n')   // A backslash and new line just join lines.
+          *w++ = *r;
+        }
+      else if (q == '"')
+        {
+        if (*r == '"')
+          q = 0;
+        else
+          *w++ = *r;
+        }
+      else if (*r == '\'' || *r == '"')
+        q = *r;
+      else
+        *w++ = *r;
+
+    if (q)
+      return false;
+
+    if (r < e)   // Past the separator before it's overwritten.
+      ++r;
+
+    *w++ = '\0';
+    }
+  }
+
+// Error handling
+enum errorstate_e { ok = 0, invalid, unknown, missing, clash };
+
+// Option flags, see option().
+enum optionflag_e
+  {
+  nonSemantic = 1,  // Doesn't change results (e.g. verbosity), not in fingerprint().
+  critical = 2,     // Converted first by populateAsync(), see cmdlinearg/async.hh.
+  memoize = 4,      // Repeated values are copied from a cache, not converted again.
+  keepRaw = 8       // The raw values given are hashed, see repopulate().
+  };
+
+// keepRaw for options of types visitTyped() can't show, see visitsTyped().
+template<typename T>
+unsigned rawFlag(const T &v)
+  {
+  return decltype(visitsTyped(v, 0))::value ? 0 : keepRaw;
+  }
+
+struct errorState
+  {
+  errorstate_e state;
+  const char *op, *val;
+  const char *at;   // Offending character within val, if known.
+  int arg;          // Position in argv of the offending argument, 0 if not known.
+
+  bool isOk() { return state == ok ; }
+  };
+
+// The main workhorse object.
+template<int max_string_length=64, int... delims>
+struct options
+  {
+  // Component objects, one for each option given.
+  // Responsible for virtualising on the type. It holds the long, short,
+  // help, and default strings and a reference to the variable to set.
+  struct argObjBase : public argStrings
+    {
+    bool seen;
+    bool failed;      // The last value (or default) given didn't convert.
+    int index;        // Order of declaration, from 0.
+    unsigned flags;   // optionflag_e's.
+    bool given;       // Given a value by the last populate, see note().
+    const char *at;   // Where the last failed setMe() went wrong, if known.
+    std::uint64_t raw, prev;  // Hash of the raw values given, if keepRaw.
+    memoBase* memo;   // Conversions kept, if flagged memoize.
+
+    argObjBase(const char *_s, const char *_l, const char *_h, const char * _d)
+      : argStrings{_s,_l,_h,_d}, seen(false), failed(false), index(0), flags(0),
+        given(false), at(nullptr), raw(rawBasis), prev(rawBasis), memo(nullptr) {};
+
+    // FNV-1a over the raw value strings, each followed by a separator.
+    static const std::uint64_t rawBasis = 0xcbf29ce484222325ULL;
+
+    void note(const char* v)
+      {
+      given = true;
+      if (!(flags & keepRaw))
+        return;
+
+      for (; *v; ++v)
+        raw = (raw ^ (unsigned char)*v) * 0x100000001b3ULL;
+      raw = (raw ^ 0x100) * 0x100000001b3ULL;
+      }
+
+
+    template<typename T, char... Ds>
+    struct delimHelper { 
+       bool isDelim(T c) const
+        {
+        for (auto x: {Ds...})
+          if ( c == x )
+            return true;
+    
+        return false;
+        };
+      };
+
+    template<typename T>
+    struct delimHelper<T> { 
+       bool isDelim(T c) const
+        {
+        return ( c == '=' || c == ':' );
+        };
+      };
+
+    template<typename T>
+    bool isDelim(T c) const
+      {
+      return ( c == '=' || c == ':' );
+      };
+
+    bool isMe(const char* &d, const char* z, int sl)
+      {
+      const char* x = z;
+      const char* y = (sl ? s : l);
+
+      d = nullptr;
+
+      if ( x == nullptr && y == nullptr )
+        return true;
+
+      if ( x == nullptr || y == nullptr )
+        return false;
+
+      while (*x != '\0' && *y != '\0' && (x-z) < max_string_length)
+        if ( *x++ != *y++)
+          return false;
+      
+      if (*y != '\0')
+        return false;
+
+      if (*x == '\0')
+        return true;
+
+      if ( sl )
+        {
+        if (delimHelper<char,delims...>().isDelim(*x))
+          ++x;
+        d = x;
+        return true;
+        }
+
+      if (delimHelper<char,delims...>().isDelim(*x))
+        {
+        d = x+1;
+        return true;
+        }
+
+      return false;
+      }
+
+    virtual bool setMe(const char* s) = 0;
+    virtual int getMe(std::string &out) = 0;
+
+    // The same on a separate value of our type living in raw memory (see
+    // overlay.hh). makeIn() constructs one at the next suitably aligned
+    // spot in [mem+used, mem+size), returning nullptr if there's no room.
+    virtual void* makeIn(unsigned char* mem, std::size_t &used, std::size_t size) = 0;
+    virtual bool setAt(void* v, const char* s, const char* &at) = 0;
+    virtual void dropAt(void* v) = 0;
+
+    // Move such a value into the variable (see repopulate()).
+    virtual void takeAt(void* v) = 0;
+
+    virtual void reset() = 0;
+    virtual void rebind(void* resource) = 0;
+    virtual bool isDefault() = 0;
+    // Show the value to w, see valueVisitor.
+    virtual void visitMe(valueVisitor &w) = 0;
+    virtual int numArgs() = 0;
+    virtual ~argObjBase() { delete memo; };
+    };
+
+  template<typename T>
+  struct argObj : public argObjBase
+    {
+    T &v;
+    virtual bool setMe(const char* s)
+      {
+      this->seen = true;
+
+      if (this->flags & memoize)
+        return memoFromString(v, s, this->at, this->memo);
+
+      return fromString(v, s, this->at);
+      }
+
+    virtual void* makeIn(unsigned char* mem, std::size_t &used, std::size_t size)
+      {
+      std::size_t a = (alignof(T) - (std::uintptr_t)(mem + used) % alignof(T)) % alignof(T);
+
+      if (used + a + sizeof(T) > size)
+        return nullptr;
+
+      used += a + sizeof(T);
+      return new (mem + used - sizeof(T)) T();
+      }
+
+    virtual bool setAt(void* x, const char* s, const char* &at)
+      {
+      return fromString(*static_cast<T*>(x), s, at);
+      }
+
+    virtual void dropAt(void* x)
+      {
+      static_cast<T*>(x)->~T();
+      }
+
+    virtual void takeAt(void* x)
+      {
+      v = std::move(*static_cast<T*>(x));
+      }
+
+    // Append the current value(s) to out, '\0' terminated, see putValues().
+    virtual int getMe(std::string &out)
+      {
+      return putValues(out, v);
+      }
+
+    // Back to an empty, unseen value (lists are emptied).
+    virtual void reset()
+      {
+      this->seen = false;
+      v = T();
+      }
+
+    virtual void rebind(void* resource)
+      {
+      if (rebindValue(v, resource, 0))
+        this->seen = false;
+      }
+
+    // Does the value match what the default would give? Without a default
+    // that means not given at all.
+    virtual bool isDefault()
+      {
+      T x = T();
+
+      if (this->d == nullptr)
+        return !this->seen;
+
+      return fromString(x, this->d) && sameValue(x, v, 0);
+      }
+
+    virtual void visitMe(valueVisitor &w)
+      {
+      visitTyped(w, v, 0);
+      }
+
+    virtual int numArgs()
+      {
+      return number_of_arguments<T>::n ;
+      }
+
+    argObj(const char* _s,const char* _l,const char* _h,const char* _d, T &_v)
+      : argObjBase(_s, _l, _h, _d), v(_v) { };
+    };
+
+  // An argObj whose values must also pass check, see option().
+  template<typename T, typename C>
+  struct checkedArgObj : public argObj<T>
+    {
+    C check;
+
+    // Convert s into t, keeping it only if it passes: a single value is
+    // converted into a copy, assigned once checked, a list's new element
+    // is dropped again.
+    bool setChecked(T &t, const char* s, const char* &at, bool memoized)
+      {
+      if (isList(t))
+        {
+        if (!(memoized ? memoFromString(t, s, at, this->memo) : fromString(t, s, at)))
+          return false;
+
+        if (check(lastValue(t), valueCount(t)))
+          return true;
+
+        dropLast(t);
+        }
+      else
+        {
+        T x(t);
+
+        if (!(memoized ? memoFromString(x, s, at, this->memo) : fromString(x, s, at)))
+          return false;
+
+        if (check(lastValue(x), 1))
+          {
+          t = std::move(x);
+          return true;
+          }
+        }
+
+      at = nullptr;
+      return false;
+      }
+
+    virtual bool setMe(const char* s)
+      {
+      this->seen = true;
+      return setChecked(this->v, s, this->at, (this->flags & memoize) != 0);
+      }
+
+    virtual bool setAt(void* x, const char* s, const char* &at)
+      {
+      return setChecked(*static_cast<T*>(x), s, at, false);
+      }
+
+    checkedArgObj(const char* _s,const char* _l,const char* _h,const char* _d, T &_v, C _check)
+      : argObj<T>(_s, _l, _h, _d, _v), check(_check) { };
+    };
+
+  struct noDefault : public argObjBase
+    {
+    virtual bool setMe(const char*) { return false ; }
+    virtual int  getMe(std::string&){ return 0; }
+    virtual void* makeIn(unsigned char*, std::size_t&, std::size_t) { return nullptr; }
+    virtual bool setAt(void*, const char*, const char* &) { return false; }
+    virtual void dropAt(void*)      {}
+    virtual void takeAt(void*)      {}
+    virtual void reset()            {}
+    virtual void rebind(void*)      {}
+    virtual bool isDefault()        { return true; }
+    virtual void visitMe(valueVisitor &) {}
+    virtual int  numArgs()          { return 0; }
+    noDefault() : argObjBase(nullptr, nullptr, nullptr, nullptr) {};
+    };
+
+  // This is the list of options to search.
+  std::forward_list<argObjBase*> options;
+
+  // Told after every populate(), if set (see cmdlinearg/usage.hh).
+  struct populateObserver
+    {
+    virtual void populated(const struct options &args) = 0;
+    virtual ~populateObserver() {};
+    };
+
+  populateObserver* observer = nullptr;
+
+  // Asked first by findArg(), if set (see cmdlinearg/tree.hh).
+  struct optionLookup
+    {
+    virtual argObjBase* find(const char* &d, const char* s, int sl) const = 0;
+    virtual ~optionLookup() {};
+    };
+
+  optionLookup* lookup = nullptr;
+
+  // The shard option, if declared (see shardOption()), and the positional
+  // values populateKnown() counted, for populateRest() to carry on from.
+  argObjBase* sharding = nullptr;
+  long shardNth = 0;
+
+  static bool isDelim(char c)
+    {
+    return typename argObjBase::template delimHelper<char,delims...>().isDelim(c);
+    }
+
+  // The delimiter to write between a name and its value.
+  static char firstDelim()
+    {
+    const int d[] = {delims..., '='};
+
+    return (char)d[0];
+    }
+
+  // Helper functions for setting defaults, and finding arguments.
+  // Defaults that fail to convert (or their checks) are added to errors,
+  // if given, the first is returned.
+  errorState setDefaults(std::vector<errorState>* errors = nullptr)
+    {
+    errorState r{ok, nullptr, nullptr, nullptr, 0};
+
+    for (auto &a: options)
+      if ( a->seen == false && a->d != nullptr && (a->failed = !a->setMe(a->d)) )
+        {
+        errorState e{invalid, a->l ? a->l : a->s, a->d, a->at, 0};
+
+        if (r.state == ok)
+          r = e;
+        if (errors)
+          errors->push_back(e);
+        }
+
+    return r;
+    }
+
+  static argObjBase* none()
+    {
+    static noDefault no;
+    return &no;
+    }
+
+  argObjBase* findDefault()
+    {
+    const char* dummy;
+
+    for (auto &i : options)
+      if (i->isMe(dummy,nullptr,0) && i->isMe(dummy,nullptr,1) )
+        return i;
+
+    return none();
+    }
+
+  argObjBase* findArg(const char* &d, const char* s, int sl) const
+    {
+    if (argObjBase* a = lookup ? lookup->find(d, s, sl) : nullptr)
+      return a;
+
+    for (auto &i : options)
+      if (i->isMe(d, s, sl) )
+        return i;
+
+    return nullptr;
+    }
+
+  // Try to process an argument, poping as many arguments as needed.
+  // Values are handed to set(option, value), which returns false if invalid.
+  template<typename F>
+  errorState proc(argSpan &l, argObjBase* defOp, F set) const
+    {
+    errorState allgood{ok, nullptr, nullptr, nullptr, 0};
+    int arg = l.pos();
+    const char *op = l.front();
+
+    l.pop_front(); 
+
+    if ( op == nullptr || op[0] == '\0')
+      return allgood;
+
+    if ( op[0] == '-' )
+      {
+      if ( op[1] == '\0' )
+        {
+        while (!l.empty())
+          {
+          int at = l.pos();
+          const char *val = l.front();
+          l.pop_front();
+          if (defOp != none() && !l.keeps(val))
+            continue;
+          if (set(defOp, val) == false)
+            return errorState{invalid, nullptr, val, defOp->at, at};
+          }
+        return allgood;
+        }
+      else 
+        {
+        const char * delm;
+
+        argObjBase* a = (op[1]=='-') ? findArg(delm, &op[2],0) 
+                                     : findArg(delm, &op[1],1);
+
+        if ( a == nullptr )
+          return errorState{unknown, op, nullptr, nullptr, arg};
+
+        // A long option that takes no value can still be given one, as
+        // in --verbose=false.
+        if ( a->numArgs() == 0 && delm && op[1] == '-' )
+          return set(a, delm) ? allgood : errorState{invalid, op, delm, a->at, arg};
+
+        if (delm)
+          l.push_front(delm);
+
+        if ( a->numArgs() == 0 )
+          return set(a, "true") ? allgood : errorState{invalid, op, "true", a->at, arg};
+        else if ( l.empty() )
+          return errorState{missing, op, nullptr, nullptr, arg};
+        else
+          {
+          int at = l.pos();
+          const char *val = l.front();
+          l.pop_front();
+          return set(a, val) ? allgood : errorState{invalid, op, val, a->at, at};
+          }
+        }
+      }
+    else if (defOp != none() && !l.keeps(op))
+      return allgood;
+    else
+      return set(defOp, op) ? allgood
+                            : errorState{invalid, "default list", op, defOp->at, arg};
+    }
+
+  static bool noteAndSet(argObjBase* a, const char* v)
+    {
+    if (a == none())   // Shared by all, and takes nothing.
+      return false;
+
+    a->note(v);
+    return !(a->failed = !a->setMe(v));
+    }
+
+  /** Register a command line option.
+
+      @variable The variable to be populated if this option is used.
+      @s_short the short string for this option without the '-' (i.e. 'o')
+      @s_long the long string for this option without the '--' (i.e. 'outfile')
+      @s_help the help string for this option (i.e. 'Output file name' )
+      @s_default the default value to use in a string as it would be on 
+                 the command line.
+      @s_flags optionflag_e's or'd together (i.e. nonSemantic)
+      @return the option's index, its order of declaration from 0.
+  */
+  template<typename T>
+  int option(T &variable, const char* s_short, const char* s_long,
+                const char* s_help, const char* s_default, unsigned s_flags = 0)
+    {
+    return add(new argObj<T>(s_short, s_long, s_help, s_default, variable),
+               s_flags | rawFlag(variable));
+    }
+
+  /** Register a command line option whose values must pass checks, each
+      as soon as it's converted: inRange(), oneOf(), lengthIn(), atMost(),
+      satisfies(), or anything callable with the value and the number of
+      values held. Values (and defaults) that fail are invalid, just as
+      those that don't convert, and aren't added to lists.
+
+      @check, @more the checks, all of which must pass.
+      Otherwise as option() above.
+  */
+  template<typename T, typename C, typename... Cs>
+  int option(T &variable, const char* s_short, const char* s_long,
+                const char* s_help, const char* s_default, unsigned s_flags, C check, Cs... more)
+    {
+    return add(new checkedArgObj<T, allOf<C, Cs...> >(s_short, s_long, s_help, s_default, variable,
+                                                      allOf<C, Cs...>(check, more...)),
+               s_flags | rawFlag(variable));
+    }
+
+  int add(argObjBase* a, unsigned s_flags)
+    {
+    int i = options.empty() ? 0 : options.front()->index + 1;
+
+    options.push_front(a);
+    options.front()->index = i;
+    options.front()->flags = s_flags;
+
+    return i;
+    }
+  
+  /** Declare the option choosing this worker's shard of the positional
+      values, as 'i/n' or 'i/n:hash' (see shard). Every populate (and
+      repopulate(), populateAsync()) drops the values of other shards as
+      it reads them, before they're converted or stored, wherever the
+      option is on the command line. With populateKnown() it must be
+      declared before, not by a plugin, and values populateRest() finds
+      to be positional are counted after those populateKnown() read.
+
+      @variable The shard, all of them ('0/1') by default.
+      @return the option's index, as option().
+  */
+  int shardOption(shard &variable, const char* s_short, const char* s_long,
+                  const char* s_help, const char* s_default = "0/1")
+    {
+    int i = option(variable, s_short, s_long, s_help, s_default);
+
+    sharding = options.front();
+    return i;
+    }
+
+  // The shard to keep, looked for ahead of the positional values and put
+  // in v. Returns nullptr if there's no shard option.
+  const shard* findShard(int c, const char *argv[], shard &v) const
+    {
+    if (sharding == nullptr)
+      return nullptr;
+
+    const char* d;
+
+    if (sharding->d == nullptr || !fromString(v, sharding->d))
+      v = shard{0, 1, false};
+
+    for (int i = 1; i < c && argv[i] && std::strcmp(argv[i], "-") != 0; ++i)
+      if (argv[i][0] == '-' && (argv[i][1] == '-' ? sharding->isMe(d, argv[i] + 2, 0)
+                                                  : sharding->isMe(d, argv[i] + 1, 1)))
+        if ((d && *d) || (i + 1 < c && (d = argv[i + 1])))
+          fromString(v, d);
+
+    return &v;
+    }
+
+  /** Populate variables given by argument() from the commandline options.
+      A default that doesn't convert, or fails its checks, is invalid.
+
+      @param argc  Inbound argument count
+      @param argv  Inbound argument vector
+  */
+  errorState populate(int c, const char *argv[]) 
+    {
+    return populate(c, argv, nullptr);
+    }
+
+  /** Populate, carrying on past errors to collect all of them in one pass
+      (e.g. to validate stored command lines). Defaults are still set, and
+      any that fail to convert, or their checks, are reported too, as by
+      populate() without errors. After an unknown option
+      the next argument is taken as a new one.
+
+      @param argc   Inbound argument count
+      @param argv   Inbound argument vector
+      @param errors Filled with every error found, in order.
+      @return the first error, if any.
+  */
+  errorState populate(int c, const char *argv[], std::vector<errorState> &errors)
+    {
+    errors.clear();
+    return populate(c, argv, &errors);
+    }
+
+  errorState populate(int c, const char *argv[], std::vector<errorState>* errors)
+    {
+    argSpan args(argv + (c > 0), argv + (c > 0 ? c : 0), 1);
+    errorState r{ok, nullptr, nullptr, nullptr, 0};
+
+    argObjBase* defOp = findDefault();
+    shard mine;
+
+    args.mine = findShard(c, argv, mine);
+
+    for (auto &a: options)
+      {
+      a->raw = argObjBase::rawBasis;
+      a->given = false;
+      a->failed = false;
+      }
+
+    while (!args.empty())
+      {
+      errorState e = proc(args, defOp, noteAndSet);
+
+      if (e.state == ok)
+        continue;
+
+      if (r.state == ok)
+        r = e;
+
+      if (errors == nullptr)
+        break;
+
+      errors->push_back(e);
+      }
+
+    if (r.state == ok || errors)
+      {
+      errorState d = setDefaults(errors);
+
+      if (r.state == ok)
+        r = d;
+      }
+
+    if (observer)
+      observer->populated(*this);
+   
+    return r;
+    }
+
+  /** Populate from a command string, e.g. one received by a job server,
+      rather than an argument vector. It's split in place by splitWords(),
+      the first word being the program name, as in argv. Reusing words
+      between calls saves all allocation.
+
+      @param line   The command string, overwritten (line[n] too).
+      @param n      Its length.
+      @param words  Scratch space, left pointing to the words in line.
+  */
+  errorState populateLine(char* line, std::size_t n, std::vector<const char*> &words)
+    {
+    if (!splitWords(line, n, words))
+      return errorState{invalid, "command line", "unclosed quote", nullptr, (int)words.size() - 1};
+
+    return populate((int)words.size(), words.data());
+    }
+
+  /** Populate, setting aside unknown options rather than failing, for
+      options only declared later, by a plugin say (see addOptions()).
+      Set aside are each unknown option and the argument after it, unless
+      the option carries its own value (as in --name=value) or the next
+      argument is another option. Defaults are set for the options
+      declared so far.
+
+      @param argc  Inbound argument count
+      @param argv  Inbound argument vector, needed again by populateRest().
+      @param rest  Filled with the positions in argv of those set aside.
+  */
+  errorState populateKnown(int c, const char *argv[], std::vector<int> &rest)
+    {
+    argSpan args(argv + (c > 0), argv + (c > 0 ? c : 0), 1);
+    errorState r{ok, nullptr, nullptr, nullptr, 0};
+
+    argObjBase* defOp = findDefault();
+    shard mine;
+
+    args.mine = findShard(c, argv, mine);
+    rest.clear();
+    for (auto &a: options)
+      {
+      a->raw = argObjBase::rawBasis;
+      a->given = false;
+      a->failed = false;
+      }
+
+    while (!args.empty() && r.state == ok)
+      if ((r = proc(args, defOp, noteAndSet)).state == unknown)
+        {
+        setAside(args, r, rest);
+        r.state = ok;
+        }
+
+    shardNth = args.nth;
+    if (r.state == ok)
+      r = setDefaults();
+
+    if (observer)
+      observer->populated(*this);
+
+    return r;
+    }
+
+  /** Parse the arguments set aside by populateKnown() again, now that more
+      options have been declared. Those still unknown are left in rest. A
+      value set aside that doesn't belong to its option after all (a bool
+      takes none) is added to the positional values. Defaults are set for
+      the options still unset, i.e. the newly declared ones.
+
+      @param argv  The argument vector given to populateKnown().
+      @param rest  The positions set aside, updated to those still unknown.
+  */
+  errorState populateRest(const char *argv[], std::vector<int> &rest)
+    {
+    std::vector<const char*> v;
+    std::vector<int> left;
+
+    for (int i: rest)
+      v.push_back(argv[i]);
+
+    argSpan args(v.data(), v.data() + v.size(), 0);
+    errorState r{ok, nullptr, nullptr, nullptr, 0};
+
+    argObjBase* defOp = findDefault();
+
+    args.mine = sharding ? &static_cast<argObj<shard>*>(sharding)->v : nullptr;
+    args.nth = shardNth;
+
+    while (!args.empty() && r.state == ok)
+      if ((r = proc(args, defOp, noteAndSet)).state == unknown)
+        {
+        setAside(args, r, left);
+        r.state = ok;
+        }
+
+    if (r.state != ok)
+      {
+      r.arg = rest[r.arg];
+      return r;
+      }
+
+    for (auto &i: left)
+      i = rest[i];
+    rest.swap(left);
+
+    return setDefaults();
+    }
+
+  // After unknown option e, put it in rest, and the next argument if that
+  // could be its value.
+  void setAside(argSpan &args, const errorState &e, std::vector<int> &rest) const
+    {
+    rest.push_back(e.arg);
+
+    for (const char* x = e.op + 1; *x; ++x)
+      if (isDelim(*x))
+        return;
+
+    if (!args.empty() && args.front()[0] != '-')
+      {
+      rest.push_back(args.pos());
+      args.pop_front();
+      }
+    }
+
+  /** Declare a batch of options as one, e.g. a plugin's, after the rest.
+      declare(*this) makes the option() calls. If any of the new options
+      shares a name with another (or two take the positional values) the
+      whole batch is removed again. Nothing needs rebuilding, the new
+      options are simply searched first.
+
+      @param declare Called with this object to declare the options.
+      @return clash and the name taken, or ok.
+  */
+  template<typename F>
+  errorState addOptions(F declare)
+    {
+    argObjBase* mark = options.empty() ? nullptr : options.front();
+
+    declare(*this);
+
+    for (auto n = options.begin(); n != options.end() && *n != mark; ++n)
+      for (auto o = std::next(n); o != options.end(); ++o)
+        if (const char* name = sameName(*n, *o))
+          {
+          while (options.front() != mark)
+            {
+            delete options.front();
+            options.pop_front();
+            }
 
-// Trait that maps a type to the number of arguments it'll consume.
-template<typename T> struct number_of_arguments         { enum { n = 1 } ; };
-template<>           struct number_of_arguments<bool>   { enum { n = 0 } ; };
+          return errorState{clash, name, nullptr, nullptr, 0};
+          }
 
-struct argStrings
-  {
-  const char *s, *l, *h, *d;
-  };
+    return errorState{ok, nullptr, nullptr, nullptr, 0};
+    }
 
-// Error handling
-enum errorstate_e { ok = 0, invalid, unknown };
+  // The name two options share, if any.
+  static const char* sameName(const argObjBase* a, const argObjBase* b)
+    {
+    if (a->s && b->s && std::strcmp(a->s, b->s) == 0)
+      return b->s;
 
-struct errorState
-  {
-  errorstate_e state;
-  const char *op, *val;
+    if (a->l && b->l && std::strcmp(a->l, b->l) == 0)
+      return b->l;
 
-  bool isOk() { return state == ok ; }
-  };
+    if (!a->s && !a->l && !b->s && !b->l)
+      return "default list";
 
-// The main workhorse object.
-template<int max_string_length=64, int... delims>
-struct options
-  {
-  // Component objects, one for each option given.
-  // Responsible for virtualising on the type. It holds the long, short,
-  // help, and default strings and a reference to the variable to set.
-  struct argObjBase : public argStrings
-    {
-    bool seen;
+    return nullptr;
+    }
 
-    argObjBase(const char *_s, const char *_l, const char *_h, const char * _d)
-      : argStrings{_s,_l,_h,_d}, seen(false) {};
+  /** Populate again from a new command line, only re-converting the options
+      whose raw values differ from those of the last populate() or
+      repopulate(). Changes are spotted by a 64 bit hash of each option's
+      value strings, kept by options flagged keepRaw. Others are flagged
+      by the first repopulate(), which re-converts them all. Changed
+      options are reset and given their new values (or their default).
+      These are converted into temporaries first, if any fails (defaults
+      included) no variable is touched and nothing is reported changed.
+
+      @param argc    Inbound argument count
+      @param argv    Inbound argument vector
+      @param changed Filled with the options that changed.
+  */
+  errorState repopulate(int c, const char *argv[], std::vector<argObjBase*> &changed)
+    {
+    argSpan args(argv + (c > 0), argv + (c > 0 ? c : 0), 1);
+    std::vector<std::pair<argObjBase*, const char*> > vals;
+    errorState r{ok, nullptr, nullptr, nullptr, 0};
 
+    argObjBase* defOp = findDefault();
+    shard mine;
+    std::vector<argObjBase*> fresh;
+    std::vector<bool> wasGiven(options.empty() ? 0 : options.front()->index + 1);
 
-    template<typename T, char... Ds>
-    struct delimHelper { 
-       bool isDelim(T c) const
+    args.mine = findShard(c, argv, mine);
+    for (auto &a: options)
+      {
+      if (!(a->flags & keepRaw))
         {
-        for (auto x: {Ds...})
-          if ( c == x )
-            return true;
-    
-        return false;
-        };
-      };
+        a->flags |= keepRaw;
+        fresh.push_back(a);
+        }
 
-    template<typename T>
-    struct delimHelper<T> { 
-       bool isDelim(T c) const
+      wasGiven[a->index] = a->given;
+      a->prev = a->raw;
+      a->raw = argObjBase::rawBasis;
+      a->given = false;
+      }
+
+    // Put back the hashes (and flags) as they were.
+    auto rollback = [&]()
+      {
+      for (auto &a: options)
         {
-        return ( c == '=' || c == ':' );
-        };
+        a->raw = a->prev;
+        a->given = wasGiven[a->index];
+        }
+
+      for (auto &a: fresh)
+        a->flags &= ~keepRaw;
       };
 
-    template<typename T>
-    bool isDelim(T c) const
+    // First just hash and keep the values.
+    auto keep = [&vals](argObjBase* a, const char* v)
       {
-      return ( c == '=' || c == ':' );
+      if (a == none())
+        return false;
+
+      a->note(v);
+      vals.push_back(std::make_pair(a, v));
+      return true;
       };
 
-    bool isMe(const char* &d, const char* z, int sl)
+    while (!args.empty() && (r = proc(args, defOp, keep)).state == ok )
+      {}
+
+    changed.clear();
+
+    if (r.state != ok)
       {
-      const char* x = z;
-      const char* y = (sl ? s : l);
+      rollback();
+      return r;
+      }
 
-      d = nullptr;
+    for (auto &a: options)
+      if (a->raw != a->prev || std::find(fresh.begin(), fresh.end(), a) != fresh.end())
+        changed.push_back(a);
 
-      if ( x == nullptr && y == nullptr )
-        return true;
+    // Temporaries made by makeIn(), in chunks of memory that never move.
+    std::forward_list<std::vector<std::max_align_t> > chunks;
+    unsigned char* mem = nullptr;
+    std::size_t used = 0, size = 0;
+    std::vector<void*> temps;
+    std::vector<bool> fromArgs(changed.size(), false);
 
-      if ( x == nullptr || y == nullptr )
-        return false;
+    for (auto &a: changed)
+      {
+      void* x;
 
-      while (*x != '\0' && *y != '\0' && (x-z) < max_string_length)
-        if ( *x++ != *y++)
-          return false;
-      
-      if (*y != '\0')
-        return false;
+      while ((x = a->makeIn(mem, used, size)) == nullptr)
+        {
+        size = size ? 2 * size : 256;
+        chunks.emplace_front(size / sizeof(std::max_align_t));
+        mem = reinterpret_cast<unsigned char*>(chunks.front().data());
+        used = 0;
+        }
 
-      if (*x == '\0')
-        return true;
+      temps.push_back(x);
+      }
 
-      if ( sl )
+    for (auto &v: vals)
+      {
+      std::size_t i = std::find(changed.begin(), changed.end(), v.first) - changed.begin();
+      const char* at = nullptr;
+
+      if (i == changed.size())
+        continue;
+
+      fromArgs[i] = true;
+      if (!v.first->setAt(temps[i], v.second, at))
         {
-        if (delimHelper<char,delims...>().isDelim(*x))
-          ++x;
-        d = x;
-        return true;
+        r = errorState{invalid, v.first->l ? v.first->l : v.first->s, v.second, at, 0};
+        break;
         }
+      }
 
-      if (delimHelper<char,delims...>().isDelim(*x))
+    for (std::size_t i = 0; i < changed.size() && r.state == ok; ++i)
+      {
+      argObjBase* a = changed[i];
+      const char* at = nullptr;
+
+      if (!fromArgs[i] && a->d != nullptr && !a->setAt(temps[i], a->d, at))
+        r = errorState{invalid, a->l ? a->l : a->s, a->d, at, 0};
+      }
+
+    for (std::size_t i = 0; i < changed.size(); ++i)
+      {
+      argObjBase* a = changed[i];
+
+      if (r.state == ok)
         {
-        d = x+1;
-        return true;
+        a->takeAt(temps[i]);
+        a->seen = fromArgs[i] || a->d != nullptr;
         }
 
-      return false;
+      a->dropAt(temps[i]);
       }
 
-    virtual bool setMe(const char* s) = 0;
-    virtual int numArgs() = 0;
-    };
+    if (r.state != ok)
+      {
+      rollback();
+      changed.clear();
+      }
 
-  template<typename T>
-  struct argObj : public argObjBase
+    return r;
+    }
+
+  /** Write the options back out as a command line, the reverse of populate(),
+      ready for execve() or posix_spawn(). Options come in order of
+      declaration, by long name where they have one, then any positional
+      values. Bools are given alone when true, as --name=false when false
+      (left out if they only have a short name). Values of types without
+      a toString() can't be written and are left out.
+
+      @param buf   Filled with the arguments, each '\0' terminated.
+      @param argv  Filled with pointers into buf, then a nullptr.
+      @param argv0 The program name to put first.
+      @param all   Also give the options left at their default values.
+  */
+  void toArgv(std::string &buf, std::vector<char*> &argv, const char* argv0,
+              bool all = false) const
     {
-    T &v;
-    virtual bool setMe(const char* s)
+    std::vector<argObjBase*> byIndex(options.begin(), options.end());
+    std::string vals;
+    argObjBase* defOp = nullptr;
+
+    std::reverse(byIndex.begin(), byIndex.end());
+
+    buf.assign(argv0 ? argv0 : "");
+    buf.push_back('\0');
+
+    for (auto a: byIndex)
       {
-      this->seen = true;
-      return fromString(v, s);
+      if ( all ? !a->seen : a->isDefault() )
+        continue;
+
+      if (a->s == nullptr && a->l == nullptr)
+        {
+        defOp = a;
+        continue;
+        }
+
+      vals.clear();
+      int n = a->getMe(vals);
+
+      for (const char* v = vals.data(); n-- > 0; v += std::strlen(v) + 1)
+        {
+        bool withValue = a->numArgs() == 0 && std::strcmp(v, "true") != 0;
+
+        if (withValue && a->l == nullptr)
+          continue;
+
+        buf += a->l ? "--" : "-";
+        buf.append(a->l ? a->l : a->s);
+        if (withValue)
+          {
+          buf.push_back(firstDelim());
+          buf.append(v);
+          }
+        buf.push_back('\0');
+
+        if (a->numArgs() != 0)
+          buf.append(v, std::strlen(v) + 1);
+        }
       }
 
-    virtual int numArgs()
+    // Positional values go last, after a '-' if any could be mistaken.
+    if (defOp)
       {
-      return number_of_arguments<T>::n ;
+      vals.clear();
+      int n = defOp->getMe(vals);
+
+      for (const char* v = vals.data(); v < vals.data() + vals.size(); v += std::strlen(v) + 1)
+        if (v[0] == '-' || v[0] == '\0')
+          {
+          buf.append("-", 2);
+          break;
+          }
+
+      if (n > 0)
+        buf.append(vals);
       }
 
-    argObj(const char* _s,const char* _l,const char* _h,const char* _d, T &_v)
-      : argObjBase(_s, _l, _h, _d), v(_v) { };
-    };
+    argv.clear();
+    for (std::size_t i = 0; i < buf.size(); i += std::strlen(&buf[i]) + 1)
+      argv.push_back(&buf[i]);
+    argv.push_back(nullptr);
+    }
 
-  struct noDefault : public argObjBase
+  // The formatted help, made once by helpTo(): every option's part of text,
+  // and its names and help in lower case to match against.
+  struct helpCache
     {
-    virtual bool setMe(const char*) { return false ; }
-    virtual int  numArgs()          { return 0; }
-    noDefault() : argObjBase(nullptr, nullptr, nullptr, nullptr) {};
+    const argObjBase* front = nullptr;
+    std::string text;
+    std::vector<const argObjBase*> by;
+    std::vector<std::pair<std::size_t, std::size_t> > at;
+    std::vector<std::string> keys;
     };
 
-  // This is the list of options to search.
-  std::forward_list<argObjBase*> options;
+  helpCache helpText;
 
-  // Helper functions for setting defaults, and finding arguments.
-  void setDefaults()
+  static void lower(std::string &s)
     {
-    for (auto &a: options)
-      if ( a->seen == false && a->d != nullptr )
-        a->setMe(a->d);
+    std::transform(s.begin(), s.end(), s.begin(), ::tolower);
     }
 
-  argObjBase* findDefault()
+  // Is a in group g, i.e. named g or g.something (or g-something)?
+  static bool inGroup(const argObjBase* a, const std::string &g)
     {
-    static noDefault no;
-    const char* dummy;
-
-    for (auto &i : options)
-      if (i->isMe(dummy,nullptr,0) && i->isMe(dummy,nullptr,1) )
-        return i;
+    std::size_t n = g.size();
 
-    return &no;
+    return g.empty() || (a->l && std::strncmp(a->l, g.c_str(), n) == 0
+                         && (a->l[n] == '\0' || a->l[n] == '.' || a->l[n] == '-'));
     }
 
-  argObjBase* findArg(const char* &d, const char* s, int sl)
+  // Append the help for a, the names then the help and default, the
+  // latter wrapped to width with lines starting at column col.
+  static void formatHelp(std::string &out, std::string &text, const argObjBase* a,
+                         std::size_t col, std::size_t width)
     {
-    for (auto &i : options)
-      if (i->isMe(d, s, sl) )
-        return i;
+    std::size_t line = out.size();
 
-    return nullptr;
-    }
+    out += a->s ? "  -" : "    ";
+    out += a->s ? a->s : "";
+    out += a->s && a->l ? ", --" : a->l ? "  --" : "";
+    out += a->l ? a->l : "";
 
-  // Try to process an argument, poping as many arguments as needed.
-  errorState proc(std::forward_list<const char*> &l, argObjBase* defOp)
-    {
-    errorState allgood{ok, nullptr, nullptr};
-    const char *op = l.front();
+    text.assign(a->h ? a->h : "");
+    if (a->d && a->d[0] != '\0')
+      text.append(text.empty() ? "" : " ").append("(default: '").append(a->d).append("')");
 
-    l.pop_front(); 
+    for (std::size_t p = 0, e; p < text.size(); p = e)
+      {
+      while (p < text.size() && text[p] == ' ')
+        ++p;
 
-    if ( op == nullptr || op[0] == '\0')
-      return allgood;
+      if (p == text.size())
+        break;
 
-    if ( op[0] == '-' )
-      {
-      if ( op[1] == '\0' )
+      if (out.size() - line + 1 > col)
         {
-        while (!l.empty())
-          {
-          const char *val = l.front();
-          l.pop_front();
-          if (defOp->setMe(val) == false)
-            return errorState{invalid, nullptr, val};
-          }
-        return allgood;
+        out += '\n';
+        line = out.size();
         }
-      else 
-        {
-        const char * delm;
-
-        argObjBase* a = (op[1]=='-') ? findArg(delm, &op[2],0) 
-                                     : findArg(delm, &op[1],1);
-
-        if ( a == nullptr )
-          return errorState{unknown, op, nullptr};
+      out.append(col - (out.size() - line), ' ');
 
-        if (delm)
-          l.push_front(delm);
+      e = std::min(text.size(), p + (width > col + 20 ? width - col : 20));
+      if (e < text.size())
+        {
+        std::size_t b = text.rfind(' ', e);
 
-        if ( a->numArgs() == 0 )
-          return a->setMe("true") ? allgood : errorState{invalid, op, "true"};
-        else
-          {
-          const char *val = l.front();
-          l.pop_front();
-          return a->setMe(val) ? allgood : errorState{invalid, op, val};
-          }
+        e = (b != std::string::npos && b > p) ? b : e;
         }
+
+      out.append(text, p, e - p);
+      out += '\n';
+      line = out.size();
       }
-    else
-      return defOp->setMe(op) ? allgood : errorState{invalid, "default list", op};
-    }
-  /** Register a command line option.
 
-      @variable The variable to be populated if this option is used.
-      @s_short the short string for this option without the '-' (i.e. 'o')
-      @s_long the long string for this option without the '--' (i.e. 'outfile')
-      @s_help the help string for this option (i.e. 'Output file name' )
-      @s_default the default value to use in a string as it would be on 
-                 the command line.
-  
-  */
-  template<typename T>
-  void option(T &variable, const char* s_short, const char* s_long,
-                const char* s_help, const char* s_default)
-    {
-    options.push_front( new argObj<T>(s_short, s_long, s_help, s_default, variable) ) ;
+    if (line != out.size())
+      out += '\n';
     }
-  
-  /** Populate variables given by argument() from the commandline options
 
-      @param argc  Inbound argument count
-      @param argv  Inbound argument vector
+  /** Append the help for the options matching pattern, in their names or
+      help in any case, and in group (see inGroup()), '' matching all. The
+      text for all the options is formatted, column wrapped, and indexed
+      once, then kept until more options are declared.
   */
-  errorState populate(int c, const char *argv[]) 
+  void helpTo(std::string &out, const std::string &pattern = "", const std::string &group = "",
+              std::size_t width = 80)
     {
-    std::forward_list<const char*> args;
-    errorState r;
+    helpCache &c = helpText;
 
-    while (c-- > 1)
-      args.push_front( argv[c] );
+    if (c.front != (options.empty() ? nullptr : options.front()))
+      {
+      std::size_t col = 0;
 
-    argObjBase* defOp = findDefault();
+      c = helpCache();
+      c.front = options.empty() ? nullptr : options.front();
 
-    while (!args.empty() && (r = proc(args, defOp)).state == ok )
-      {}
+      for (auto a: options)
+        if (a->s || a->l)
+          {
+          c.by.push_back(a);
+          col = std::max(col, 10 + (a->l ? std::strlen(a->l) : 0) + (a->s ? std::strlen(a->s) : 0));
+          }
 
-    if (r.state == ok)
-      setDefaults();
-   
-    return r;
+      std::reverse(c.by.begin(), c.by.end());
+      col = std::min<std::size_t>(col, 32);
+
+      std::string text;
+
+      c.keys.resize(c.by.size());
+      for (std::size_t i = 0; i < c.by.size(); ++i)
+        {
+        const argObjBase* a = c.by[i];
+        std::size_t b = c.text.size();
+
+        formatHelp(c.text, text, a, col, width);
+        c.at.push_back(std::make_pair(b, c.text.size() - b));
+
+        c.keys[i].append(a->s ? a->s : "").append(" ").append(a->l ? a->l : "")
+                 .append(" ").append(a->h ? a->h : "");
+        lower(c.keys[i]);
+        }
+      }
+
+    if (pattern.empty() && group.empty())
+      {
+      out += c.text;
+      return;
+      }
+
+    std::string p(pattern);
+
+    lower(p);
+    for (std::size_t i = 0; i < c.by.size(); ++i)
+      if (inGroup(c.by[i], group) && c.keys[i].find(p) != std::string::npos)
+        out.append(c.text, c.at[i].first, c.at[i].second);
     }
 
   /** Boiler plate for quick default usage and help (see populate)
@@ -442,9 +2134,13 @@ struct options
   template<typename O>
   bool populateWithHelp(int argc, const char* argv[], O& os, const std::string usage="")
     {
-    static bool help = false;
+    static helpRequest help;
+    static std::string helpGroup;
 
-    option( help, "h", "help", "Display help.", nullptr );
+    option( help, "h", "help", "Display help, --help=<pattern> only for the matching options.",
+            nullptr, nonSemantic );
+    option( helpGroup, nullptr, "help-group", "Display help for the options in a group.",
+            nullptr, nonSemantic );
 
     errorState e = populate(argc, argv);
 
@@ -455,12 +2151,17 @@ struct options
       return true;
       }
 
-    if (help)
+    if (help.on || !helpGroup.empty())
       {
+      std::string out;
+
       if (usage != "")
-        os << usage << "\n";
+        out += usage + "\n";
+
+      helpTo(out, help.pattern, helpGroup);
+      out += "\n";
 
-      os << *this << "\n" ;
+      os << out;
       os.flush();
 
       return true;
@@ -523,15 +2224,79 @@ O& operator<<(O& o, errorState &e)
     case invalid:
       o << "Invalid Value: '" << (e.val ? e.val : "(null)")
          << "' for option '" << (e.op ? e.op : "(null)") << "'";
+      if (e.at && e.val)
+        o << " at offset " << (e.at - e.val);
       break;
 
     case unknown:
       o << "Unknown Option: '" << (e.op ? e.op : "(null)") << "'";
       break;
+
+    case missing:
+      o << "Missing Value for option '" << (e.op ? e.op : "(null)") << "'";
+      break;
+
+    case clash:
+      o << "Option Declared Twice: '" << (e.op ? e.op : "(null)") << "'";
+      break;
     }
 
+  if (e.state != ok && e.arg > 0)
+    o << " (argument " << e.arg << ")";
+
   return o;
   }
+
+#ifdef __cpp_lib_memory_resource
+/** Re-create the variables of all std::pmr string and list options, empty
+    and unseen, on memory resource r, so that converting values into them, and their
+    growth, allocate from r. Other options are left as they are. The old
+    values are destroyed, so rebind before dropping the resource they
+    were on; a monotonic_buffer_resource, say, can then be released at
+    once.
+
+    @param args  The options.
+    @param r     e.g. a per request arena.
+*/
+template<int... Ns>
+void useResource(options<Ns...> &args, std::pmr::memory_resource* r)
+  {
+  for (auto a: args.options)
+    a->rebind(r);
+  }
+
+/** populate() with the std::pmr options' values allocated from r, see
+    useResource().
+*/
+template<int... Ns>
+errorState populate(options<Ns...> &args, std::pmr::memory_resource* r, int c, const char *argv[])
+  {
+  useResource(args, r);
+  return args.populate(c, argv);
+  }
+#endif
+
+// The types instantiated ahead of time in the compiled library.
+#define CMDLINEARG_BUILTIN_TYPES(X) \
+  X(int) X(float) X(bool) X(std::string) \
+  X(std::vector<int>) X(std::vector<float>) X(std::vector<std::string>)
+
+// Linking against the compiled library (see CMakeLists.txt) defines
+// CMDLINEARG_PRECOMPILED, so options<> isn't instantiated in every
+// translation unit again.
+#ifdef CMDLINEARG_PRECOMPILED
+#define CMDLINEARG_EXTERN(T) \
+  extern template struct options<>::argObj<T>; \
+  extern template int options<>::option<T>(T&, const char*, const char*, \
+                                           const char*, const char*, unsigned);
+
+extern template struct options<>;
+extern template bool options<>::populateWithHelp<std::ostream>(int, const char*[],
+                                        std::ostream&, const std::string);
+CMDLINEARG_BUILTIN_TYPES(CMDLINEARG_EXTERN)
+
+#undef CMDLINEARG_EXTERN
+#endif
 } // namespace arguments
 
 //HH_CMDLINEARG_HH
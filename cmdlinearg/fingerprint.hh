@@ -0,0 +1,225 @@
+/**
+  @file: fingerprint.hh
+
+  @brief: A stable 128 bit hash of the effective values of a set of
+          options, e.g. to key caches on.
+
+fingerprint() hashes each option's names and its value in typed form (see
+valueVisitor), in one pass, containers included, with hash128: two xxh64
+style lanes over little endian words, so the result is the same across
+runs and platforms.
+
+example usage :
+  ...
+
+  int verbose;
+
+  args.option(verbose, "v", "verbose", "Chatter", "0", arguments::nonSemantic);
+  ...
+  args.populate(argc, argv);
+
+  auto key = arguments::fingerprint(args);   // Same whatever -v is.
+
+Options flagged nonSemantic are left out, as are the values of options
+neither given nor defaulted. Numbers and strings are hashed as such, values
+of other types by their toString() form. Types with neither are hashed by
+the strings they were given on the command line, so the same value given
+two ways (say '0x10' and '16') hashes differently, and values set since
+(through an optionTree, say) aren't seen.
+
+*/
+
+#ifndef HH_CMDLINEARG_FINGERPRINT_HH
+#define HH_CMDLINEARG_FINGERPRINT_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "cmdlinearg.hh"
+
+namespace arguments {
+
+// A stable streaming 128 bit hash, two xxh64 style lanes. Input is taken a
+// little endian 64 bit word at a time, so results match across platforms.
+struct hash128
+  {
+  std::uint64_t a, b, n;
+
+  static const std::uint64_t p1 = 11400714785074694791ULL, p2 = 14029467366897019727ULL,
+                             p3 =  1609587929392839681ULL, p5 =  2870177450012600261ULL;
+
+  static std::uint64_t rotl(std::uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+  static std::uint64_t round(std::uint64_t acc, std::uint64_t x)
+    {
+    return rotl(acc + x * p2, 31) * p1;
+    }
+
+  static std::uint64_t avalanche(std::uint64_t h)
+    {
+    h = (h ^ (h >> 33)) * p2;
+    h = (h ^ (h >> 29)) * p3;
+    return h ^ (h >> 32);
+    }
+
+  hash128(std::uint64_t seed = 0) : a(seed + p1 + p2), b(seed - p1), n(0) {};
+
+  void word(std::uint64_t x)
+    {
+    a = round(a, x);
+    b = round(b, rotl(x, 32) ^ p3);
+    ++n;
+    }
+
+  // Length and then the bytes.
+  void bytes(const void* p, std::size_t len)
+    {
+    const unsigned char* c = static_cast<const unsigned char*>(p);
+    std::uint64_t x;
+
+    word(len);
+    for (; len >= 8; len -= 8, c += 8)
+      {
+      std::memcpy(&x, c, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      x = __builtin_bswap64(x);
+#endif
+      word(x);
+      }
+
+    for (x = 0; len > 0; )
+      x = x << 8 | c[--len];
+    word(x);
+    }
+
+  std::pair<std::uint64_t, std::uint64_t> digest() const
+    {
+    std::uint64_t lo = avalanche(a ^ (n * p5));
+
+    return std::make_pair(lo, avalanche((b + rotl(a, 17)) ^ lo));
+    }
+  };
+
+// Feeds the values visitMe() shows it to a hash128 in a canonical form:
+// numbers as 64 bit words, whatever their size, and -0.0 as 0.0.
+struct hashVisitor : public valueVisitor
+  {
+  hash128 &h;
+  bool byRaw;     // Shown a value it can't hash, see fingerprint().
+
+  hashVisitor(hash128 &_h) : h(_h), byRaw(false) {};
+
+  template<typename T>
+  static std::uint64_t load(const unsigned char* p)
+    {
+    T x;
+
+    std::memcpy(&x, p, sizeof(x));
+    return (std::uint64_t)(std::int64_t)x;
+    }
+
+  static std::uint64_t word(const unsigned char* p, std::uint16_t elem, std::uint32_t size)
+    {
+    if (elem == floatElem && size == sizeof(float))
+      {
+      float v;
+      std::uint32_t x;
+
+      std::memcpy(&v, p, sizeof(v));
+      if (v == 0)
+        v = 0;
+      std::memcpy(&x, &v, sizeof(x));
+      return x;
+      }
+
+    if (elem == floatElem && size == sizeof(double))
+      {
+      double v;
+      std::uint64_t x;
+
+      std::memcpy(&v, p, sizeof(v));
+      if (v == 0)
+        v = 0;
+      std::memcpy(&x, &v, sizeof(x));
+      return x;
+      }
+
+    if (elem == boolElem)
+      return *p != 0;
+
+    bool s = elem == signedElem;
+
+    switch (size)
+      {
+      case 1: return s ? load<std::int8_t>(p)  : load<std::uint8_t>(p);
+      case 2: return s ? load<std::int16_t>(p) : load<std::uint16_t>(p);
+      case 4: return s ? load<std::int32_t>(p) : load<std::uint32_t>(p);
+      default: return load<std::uint64_t>(p);
+      }
+    }
+
+  virtual void number(const void* p, std::uint16_t elem, std::uint32_t size)
+    {
+    h.word(word(static_cast<const unsigned char*>(p), elem, size));
+    }
+
+  virtual void numbers(const void* p, std::size_t n, std::uint16_t elem, std::uint32_t size)
+    {
+    const unsigned char* c = static_cast<const unsigned char*>(p);
+
+    h.word(n);
+    for (std::size_t i = 0; i < n; ++i)
+      h.word(word(c + i * size, elem, size));
+    }
+
+  virtual void string(const char* s, std::size_t n)
+    {
+    h.bytes(s, n);
+    }
+
+  virtual void strings(const std::string &s, std::size_t n)
+    {
+    h.word(n);
+    h.bytes(s.data(), s.size());
+    }
+
+  virtual void opaque()
+    {
+    byRaw = true;
+    }
+  };
+
+/** A stable 128 bit hash of the effective values of args.
+
+    @param args  A populated options object.
+    @return the hash, in two halves.
+*/
+template<typename Options>
+std::pair<std::uint64_t, std::uint64_t> fingerprint(const Options &args)
+  {
+  hash128 h;
+
+  for (auto &a: args.options)
+    if (!(a->flags & nonSemantic))
+      {
+      hashVisitor v(h);
+
+      h.bytes(a->s, a->s ? std::strlen(a->s) : 0);
+      h.bytes(a->l, a->l ? std::strlen(a->l) : 0);
+      h.word(a->seen);
+      if (a->seen)
+        a->visitMe(v);
+      if (v.byRaw)
+        h.word(a->raw);
+      }
+
+  return h.digest();
+  }
+
+} // namespace arguments
+
+//HH_CMDLINEARG_FINGERPRINT_HH
+#endif
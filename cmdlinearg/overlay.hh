@@ -0,0 +1,177 @@
+/**
+  @file: overlay.hh
+
+  @brief: Cheap per-request option overrides layered over a shared, already
+          populated, arguments::options object.
+
+An arguments::overlay holds a handful of overriding values, keyed by option
+index (as returned by option()), in a fixed arena inside the overlay
+itself. Reads look in the overlay and fall through to the base variable.
+Neither parsing nor lookup allocates for values that fit in their type's
+own storage (numbers, bools, strings short enough for the small string
+buffer); containers and long strings still use their own allocator.
+
+The base is only read, so many overlays, on many threads, can share one.
+
+example usage :
+  ...
+
+  int threads, depth;
+  arguments::options<> args;
+
+  int iThreads = args.option(threads, "t", "threads", "Worker threads", "4" );
+  int iDepth   = args.option(depth, "d", "depth", "Search depth", "8" );
+
+  args.populate(argc, argv);
+
+  ...
+  // Per request, with the request's own few flags in 'flags':
+  arguments::overlay<arguments::options<> > o(args);
+
+  if (!o.apply(nflags, flags).isOk())
+    ...
+
+  search(o.get(iDepth, depth), o.get(iThreads, threads));
+
+apply() takes the tokens alone, there's no program name to skip. Giving an
+option again replaces a single value and appends to a list, just as on the
+command line. Positional values aren't accepted. Running out of room, in
+the arena or for entries (see the template parameters), is reported as an
+invalid value.
+
+*/
+
+#ifndef HH_CMDLINEARG_OVERLAY_HH
+#define HH_CMDLINEARG_OVERLAY_HH
+
+#include <cstddef>
+
+#include "cmdlinearg.hh"
+
+namespace arguments {
+
+template<typename Options, std::size_t arenaSize = 256, int maxOverrides = 8>
+struct overlay
+  {
+  typedef typename Options::argObjBase argObjBase;
+
+  struct entry
+    {
+    argObjBase *a;
+    void *v;
+    };
+
+  const Options &base;
+  int n;
+  std::size_t used;
+  entry entries[maxOverrides];
+  alignas(std::max_align_t) unsigned char arena[arenaSize];
+
+  overlay(const Options &_base) : base(_base), n(0), used(0) {}
+  ~overlay() { clear(); }
+
+  overlay(const overlay&) = delete;
+  overlay& operator=(const overlay&) = delete;
+
+  // Drop all overrides, ready for reuse.
+  void clear()
+    {
+    while (n > 0)
+      {
+      --n;
+      entries[n].a->dropAt(entries[n].v);
+      }
+    used = 0;
+    }
+
+  entry* find(int index)
+    {
+    for (int i = 0; i < n; ++i)
+      if (entries[i].a->index == index)
+        return &entries[i];
+
+    return nullptr;
+    }
+
+  const entry* find(int index) const
+    {
+    return const_cast<overlay*>(this)->find(index);
+    }
+
+  /** Add overrides from a list of option tokens.
+
+      @param c     Number of tokens
+      @param argv  The tokens
+  */
+  errorState apply(int c, const char *argv[])
+    {
+    argSpan args(argv, argv + (c > 0 ? c : 0), 1);
+    errorState r{ok, nullptr, nullptr, nullptr, 0};
+    const char* at = nullptr;
+
+    auto set = [this, &at](argObjBase* a, const char* s)
+      {
+      at = nullptr;
+
+      // A positional value, none() has no index of its own.
+      if (a == Options::none())
+        return false;
+
+      entry* e = find(a->index);
+
+      if (e != nullptr)
+        return e->a->setAt(e->v, s, at);
+
+      // A new entry only once its first value has converted, otherwise
+      // reads would find a default constructed value.
+      std::size_t was = used;
+      void* v = (n < maxOverrides) ? a->makeIn(arena, used, arenaSize) : nullptr;
+
+      if (v == nullptr)
+        return false;
+
+      if (!a->setAt(v, s, at))
+        {
+        a->dropAt(v);
+        used = was;
+        return false;
+        }
+
+      entries[n++] = entry{a, v};
+      return true;
+      };
+
+    while (!args.empty()
+           && (r = base.proc(args, Options::none(), set)).state == ok)
+      {}
+
+    if (r.state == invalid)
+      r.at = at;
+
+    return r;
+    }
+
+  // Is the option with this index overridden?
+  bool has(int index) const
+    {
+    return find(index) != nullptr;
+    }
+
+  /** The value of an option, overridden or not.
+
+      @param index  The option's index, as returned by option().
+      @param v      The option's variable in the base.
+  */
+  template<typename T>
+  const T& get(int index, const T &v) const
+    {
+    const entry* e = find(index);
+
+    return e ? *static_cast<const T*>(e->v) : v;
+    }
+  };
+
+} // namespace arguments
+
+//HH_CMDLINEARG_OVERLAY_HH
+#endif
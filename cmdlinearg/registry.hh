@@ -0,0 +1,132 @@
+/**
+  @file: registry.hh
+
+  @brief: Declare options next to the code that uses them, in any
+          translation unit, and have them all picked up by main().
+          (ELF targets with GCC or Clang, uses a linker section).
+
+CMDLINEARG_FLAG() defines a variable and a constant descriptor for it. A
+pointer to the descriptor goes in the 'cmdlinearg_flags' linker section,
+which the linker gathers from every object file into one table. Nothing
+runs before main(): the descriptors are constant initialised, so there is
+no static initialisation order to get wrong and no registration call per
+option.
+
+example usage :
+
+  // cache.cc
+  CMDLINEARG_FLAG(int, cacheSize, "C", "cache-size", "Cache size in MB", "64");
+
+  // net.cc
+  CMDLINEARG_FLAG(std::string, listenAddr, nullptr, "listen", "Address to bind", "[::]:80");
+
+  // main.cc
+  CMDLINEARG_DECLARE(int, cacheSize);
+
+  int main(int argc, const char* argv[])
+    {
+    arguments::options<> args;
+
+    arguments::addRegistered(args);
+    if ( args.populateWithHelp(argc, argv, std::cerr) )
+      exit(1);
+    ...
+    }
+
+addRegistered() declares the registered options on args in order of long
+(then short) name, so the help output and option indices don't depend on
+link order. It can be mixed freely with ordinary option() calls.
+
+The options type the descriptors are built for is arguments::options<>,
+to use another define CMDLINEARG_REGISTRY_OPTIONS, the same way in every
+translation unit, before including this header.
+
+Flags must be declared at namespace scope. Their variables are default
+constructed until populate() sets them, so they shouldn't be read from
+other static initialisers.
+
+*/
+
+#ifndef HH_CMDLINEARG_REGISTRY_HH
+#define HH_CMDLINEARG_REGISTRY_HH
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "cmdlinearg.hh"
+
+#ifndef CMDLINEARG_REGISTRY_OPTIONS
+#define CMDLINEARG_REGISTRY_OPTIONS arguments::options<>
+#endif
+
+namespace arguments {
+
+typedef CMDLINEARG_REGISTRY_OPTIONS registryOptions;
+
+struct flagDesc
+  {
+  void *variable;
+  const char *s_short, *s_long, *s_help, *s_default;
+  void (*add)(registryOptions &args, const flagDesc &f);
+  };
+
+template<typename T>
+void addFlag(registryOptions &args, const flagDesc &f)
+  {
+  args.option(*static_cast<T*>(f.variable), f.s_short, f.s_long, f.s_help, f.s_default);
+  }
+
+// The section holds pointers only, so the compiler can't pad or
+// over-align the entries apart.
+extern "C" const flagDesc* const __start_cmdlinearg_flags[] __attribute__((weak));
+extern "C" const flagDesc* const __stop_cmdlinearg_flags[] __attribute__((weak));
+
+inline bool flagBefore(const flagDesc* a, const flagDesc* b)
+  {
+  int c = std::strcmp(a->s_long ? a->s_long : "", b->s_long ? b->s_long : "");
+
+  if (c == 0)
+    c = std::strcmp(a->s_short ? a->s_short : "", b->s_short ? b->s_short : "");
+
+  return c < 0;
+  }
+
+/** Declare every option registered with CMDLINEARG_FLAG() on args.
+
+    @param args  The options object that will do the populating.
+
+    Returns the number of options added.
+*/
+inline int addRegistered(registryOptions &args)
+  {
+  if (__start_cmdlinearg_flags == nullptr)
+    return 0;
+
+  std::vector<const flagDesc*> flags(__start_cmdlinearg_flags, __stop_cmdlinearg_flags);
+
+  std::stable_sort(flags.begin(), flags.end(), flagBefore);
+
+  for (auto f: flags)
+    f->add(args, *f);
+
+  return (int)flags.size();
+  }
+
+} // namespace arguments
+
+/** Define variable 'name' of 'type' and register it as an option, the
+    remaining arguments are as for option().
+*/
+#define CMDLINEARG_FLAG(type, name, s_short, s_long, s_help, s_default)       \
+  type name;                                                                  \
+  static const arguments::flagDesc cmdlinearg_flag_##name =                   \
+    { &name, s_short, s_long, s_help, s_default, &arguments::addFlag<type> }; \
+  __attribute__((used, section("cmdlinearg_flags")))                          \
+  static const arguments::flagDesc* const cmdlinearg_flagp_##name = &cmdlinearg_flag_##name
+
+// Use a flag defined in another translation unit.
+#define CMDLINEARG_DECLARE(type, name) extern type name
+
+//HH_CMDLINEARG_REGISTRY_HH
+#endif
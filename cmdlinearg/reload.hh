@@ -0,0 +1,391 @@
+/**
+  @file: reload.hh
+
+  @brief: Hot reloading of file sourced options for long running programs.
+          (Linux only, uses inotify).
+
+The arguments::reloadable class keeps a parsed configuration in an
+immutable snapshot. The configuration is re-parsed whenever its source file
+changes and the new snapshot is swapped in atomically, readers keep using
+whichever snapshot they started with.
+
+example usage :
+  ...
+
+  struct config
+    {
+    string outfile;
+    int threads;
+    };
+
+  void schema(arguments::options<> &args, config &c)
+    {
+    args.option(c.outfile, "o", "outfile", "Output file name", "out.dat" );
+    args.option(c.threads, "t", "threads", "Worker threads", "4" );
+    }
+
+  arguments::reloadable<config> cfg(schema, "/etc/foo.conf", argc, argv);
+
+  if ( !cfg.reload().isOk() )
+    ...
+
+  cfg.watch();
+
+  ...
+  // On the hot path:
+  arguments::reloadable<config>::reader c(cfg);
+  spawn(c->threads);
+
+Settings can also be changed at run time, a batch at a time, with set()
+and read back as strings with get(), see cmdlinearg/admin.hh for a local
+admin channel built on them.
+
+The file holds arguments just as they would be given on the command line,
+quoted as in the shell, with '#' starting a comment to the end of the line :
+
+  # foo.conf
+  --threads 8
+  -o /var/tmp/foo.out
+
+Each snapshot is made by a single populate() over the file's arguments
+followed by the real command line ones, so the command line wins for
+single valued options, lists collect both and defaults fill in anything
+seen in neither. A reload that fails to parse leaves the current snapshot
+in place.
+
+A reader costs two atomic adds on a shared counter and one load, and never
+waits. The writer (reload() or the watcher thread) publishes with an
+atomic pointer swap and then waits for the readers of the old snapshot to
+drain, RCU style, before freeing it. Readers should therefore not hold on
+to a reader object for long.
+
+*/
+
+#ifndef HH_CMDLINEARG_RELOAD_HH
+#define HH_CMDLINEARG_RELOAD_HH
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "cmdlinearg.hh"
+
+namespace arguments {
+
+// Split a buffer of arguments in place as the shell would (see
+// splitWords()), a '#' starting a word comments out the rest of the line.
+// The pointers added to out point into text. Returns false if a quote isn't
+// closed.
+inline bool splitArgs(std::string &text, std::vector<const char*> &out)
+  {
+  std::vector<const char*> words;
+  char q = 0;
+
+  for (std::size_t i = 0; i < text.size(); ++i)
+    if (q == 0 && text[i] == '#' && (i == 0 || std::isspace((unsigned char)text[i - 1])))
+      while (i < text.size() && text[i] != '\n')
+        text[i++] = ' ';
+    else if (text[i] == '\\' && q != '\'')
+      ++i;
+    else if (q == 0 && (text[i] == '\'' || text[i] == '"'))
+      q = text[i];
+    else if (text[i] == q)
+      q = 0;
+
+  if (!splitWords(&text[0], text.size(), words))
+    return false;
+
+  out.insert(out.end(), words.begin(), words.end());
+  return true;
+  }
+
+template<typename Config, typename Options = options<> >
+struct reloadable
+  {
+  typedef std::function<void(Options&, Config&)> schema_f;
+
+  // An immutable parsed configuration and the options bound to it.
+  struct snapshot
+    {
+    Config c;
+    Options args;
+
+    snapshot(const schema_f &schema) : c() { schema(args, c); }
+    snapshot(const schema_f &schema, const Config &from) : c(from) { schema(args, c); }
+    ~snapshot() { for (auto a: args.options) delete a; }
+    };
+
+  // Read access to the current snapshot for as long as this object lives.
+  struct reader
+    {
+    const reloadable &r;
+    int e;
+    const snapshot *s;
+    const Config *c;
+
+    reader(const reloadable &_r) : r(_r), e(r.epoch.load() & 1)
+      {
+      r.readers[e].n.fetch_add(1);
+      s = r.current.load();
+      c = &s->c;
+      }
+
+    ~reader() { r.readers[e].n.fetch_sub(1); }
+
+    reader(const reader&) = delete;
+    reader& operator=(const reader&) = delete;
+
+    const Config* operator->() const { return c; }
+    const Config& operator*()  const { return *c; }
+    };
+
+  schema_f schema;
+  std::string path;
+  int argc;
+  const char **argv;
+
+  // Called by the watcher thread after each reload it does.
+  std::function<void(const errorState&)> onReload;
+
+  std::atomic<snapshot*> current;
+
+  struct alignas(64) counter { std::atomic<long> n; };
+  mutable std::atomic<unsigned> epoch;
+  mutable counter readers[2];
+
+  // Writers, i.e. reload() and anyone publishing, hold this.
+  std::mutex writer;
+  std::string text;
+
+  std::thread watcher;
+  int stopFd[2];
+
+  /** Set up, without parsing anything yet (see reload).
+
+      @param schema  Declares the options, binding them to a Config.
+      @param path    The file to read arguments from.
+      @param argc    Command line argument count.
+      @param argv    Command line argument vector, must outlive this object.
+  */
+  reloadable(schema_f _schema, const std::string &_path, int _argc, const char *_argv[])
+    : schema(_schema), path(_path), argc(_argc), argv(_argv),
+      current(new snapshot(schema)), epoch(0), stopFd{-1, -1}
+    {
+    readers[0].n = 0;
+    readers[1].n = 0;
+    }
+
+  ~reloadable()
+    {
+    stop();
+    delete current.load();
+    }
+
+  /** Re-read the file and publish a new snapshot if it parses.
+
+      The returned errorState may point into the file's text, it stays
+      valid until the next reload.
+  */
+  errorState reload()
+    {
+    std::lock_guard<std::mutex> lock(writer);
+    std::ifstream f(path);
+    std::vector<const char*> args;
+
+    if (!f)
+      return errorState{invalid, "config file", path.c_str(), nullptr, 0};
+
+    text.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+
+    args.push_back(argc > 0 ? argv[0] : "");
+    if (!splitArgs(text, args))
+      return errorState{invalid, "config file", "unclosed quote", nullptr, 0};
+    for (int i = 1; i < argc; ++i)
+      args.push_back(argv[i]);
+
+    snapshot* s = new snapshot(schema);
+    errorState e = s->args.populate((int)args.size(), args.data());
+
+    if (e.isOk())
+      publish(s);
+    else
+      delete s;
+
+    return e;
+    }
+
+  /** Apply a batch of settings, given as (long name, value) pairs, to a
+      copy of the current snapshot and publish it only if they all succeed.
+
+      The first setting of an option in a batch replaces its value (lists
+      are emptied first), any more append as they would on the command line.
+      Readers are never blocked, they see the whole batch or none of it.
+  */
+  errorState set(const std::vector<std::pair<const char*, const char*> > &batch)
+    {
+    std::lock_guard<std::mutex> lock(writer);
+    snapshot* s = new snapshot(schema, current.load()->c);
+    std::vector<typename Options::argObjBase*> done;
+
+    for (auto &kv: batch)
+      {
+      const char* d;
+      typename Options::argObjBase* a = s->args.findArg(d, kv.first, 0);
+
+      if (a == nullptr || d != nullptr)
+        {
+        delete s;
+        return errorState{unknown, kv.first, nullptr, nullptr, 0};
+        }
+
+      if (std::find(done.begin(), done.end(), a) == done.end())
+        {
+        a->reset();
+        done.push_back(a);
+        }
+
+      if (!a->setMe(kv.second))
+        {
+        errorState e{invalid, kv.first, kv.second, a->at, 0};
+        delete s;
+        return e;
+        }
+      }
+
+    publish(s);
+    return errorState{ok, nullptr, nullptr, nullptr, 0};
+    }
+
+  /** Fetch the current value(s) of an option by long name, lists are
+      space separated. Returns false for an unknown option.
+  */
+  bool get(const char* name, std::string &out) const
+    {
+    reader r(*this);
+    const char* d;
+    typename Options::argObjBase* a = r.s->args.findArg(d, name, 0);
+
+    if (a == nullptr || d != nullptr)
+      return false;
+
+    std::string::size_type from = out.size();
+
+    if (a->getMe(out) > 0)
+      out.pop_back();
+    std::replace(out.begin() + from, out.end(), '\0', ' ');
+
+    return true;
+    }
+
+  // Swap in a new snapshot and free the old one once no reader can see it.
+  // The caller must hold the writer lock.
+  void publish(snapshot* s)
+    {
+    snapshot* old = current.exchange(s);
+
+    synchronize();
+    delete old;
+    }
+
+  // Wait until every reader that started before now has finished. Flipping
+  // the epoch twice catches readers that read the epoch before a flip but
+  // counted themselves after it.
+  void synchronize()
+    {
+    for (int i = 0; i < 2; ++i)
+      {
+      unsigned e = epoch.fetch_add(1) & 1;
+
+      while (readers[e].n.load() != 0)
+        std::this_thread::yield();
+      }
+    }
+
+  /** Start a thread that reloads whenever the file is written or replaced.
+      Watching the directory means editors that save by renaming work too.
+  */
+  bool watch()
+    {
+    std::string::size_type slash = path.rfind('/');
+    std::string dir  = (slash == std::string::npos) ? "." : path.substr(0, slash + 1);
+    std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+
+    if (watcher.joinable() || pipe(stopFd) != 0)
+      return false;
+
+    int fd = inotify_init1(IN_CLOEXEC);
+
+    if (fd < 0 || inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+      {
+      if (fd >= 0)
+        close(fd);
+      close(stopFd[0]);
+      close(stopFd[1]);
+      return false;
+      }
+
+    watcher = std::thread([this, fd, name]
+      {
+      alignas(inotify_event) char buf[4096];
+      pollfd fds[2] = { {fd, POLLIN, 0}, {stopFd[0], POLLIN, 0} };
+
+      while (poll(fds, 2, -1) >= 0 && !(fds[1].revents & POLLIN))
+        {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        bool hit = false;
+
+        for (char* p = buf; p < buf + n; )
+          {
+          inotify_event* ev = (inotify_event*)p;
+
+          if (ev->len && name == ev->name)
+            hit = true;
+          p += sizeof(inotify_event) + ev->len;
+          }
+
+        if (hit)
+          {
+          errorState e = reload();
+          if (onReload)
+            onReload(e);
+          }
+        }
+
+      close(fd);
+      });
+
+    return true;
+    }
+
+  // Stop the watcher thread, if running.
+  void stop()
+    {
+    if (!watcher.joinable())
+      return;
+
+    char c = 0;
+    if (write(stopFd[1], &c, 1) == 1)
+      watcher.join();
+    else
+      watcher.detach();
+
+    close(stopFd[0]);
+    close(stopFd[1]);
+    }
+  };
+
+} // namespace arguments
+
+//HH_CMDLINEARG_RELOAD_HH
+#endif
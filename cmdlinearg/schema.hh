@@ -0,0 +1,268 @@
+/**
+  @file: schema.hh
+
+  @brief: Describe the options as a constexpr table and have the usual
+          mistakes in it caught at compile time. (C++14).
+
+At run time findArg() takes the first option that matches, so a repeated
+name silently hides the later option, and a default that doesn't convert
+only shows up when populate() runs. Declared from a schema instead, these
+are compile errors :
+
+  duplicate short or long names (or two positional options),
+  a default that fromString() would reject, for int, float and bool,
+  a bool declared with an argument, bools are set by presence, use flag().
+
+example usage :
+
+  constexpr arguments::optionSpec jobSchema[] = {
+    arguments::opt<std::string>("o", "outfile", "Output file name", "out.dat"),
+    arguments::opt<int>("c", "count", "Number of loops", "13"),
+    arguments::opt<std::vector<int> >("w", "w", "w list", nullptr),
+    arguments::flag("v", "verbose", "Talk more"),
+  };
+  CMDLINEARG_CHECK_SCHEMA(jobSchema);
+
+  ...
+
+  arguments::declare<jobSchema, 0>(args, outfile);
+  arguments::declare<jobSchema, 1>(args, count);
+  arguments::declare<jobSchema, 2>(args, ws);
+  arguments::declare<jobSchema, 3>(args, verbose);
+
+declare() is option() with the strings taken from the schema, and checks
+the variable has the type the schema entry was made with. The schema must
+be at namespace scope (it's used as a template argument).
+
+The index of the failing entry is in the compiler's message, as in
+'duplicateNameAt<3>'. Defaults of other types are only checked at run time, by
+populate(). Keep to the names of populateWithHelp()'s '-h', '--help'.
+
+*/
+
+#ifndef HH_CMDLINEARG_SCHEMA_HH
+#define HH_CMDLINEARG_SCHEMA_HH
+
+#if __cplusplus < 201402L
+#error "cmdlinearg/schema.hh needs C++14 or later"
+#endif
+
+#include <cstddef>
+#include <string>
+
+#include "cmdlinearg.hh"
+
+namespace arguments {
+
+// The value types a schema can check the defaults of.
+enum speckind_e { otherSpec = 0, intSpec, floatSpec, boolSpec, stringSpec };
+
+struct optionSpec
+  {
+  const char *s, *l, *h, *d;
+  int kind;         // speckind_e of the value, or of the elements of a list.
+  bool list;
+  bool hasArg;
+  unsigned flags;   // optionflag_e's.
+  };
+
+template<typename T> struct specKindOf              { enum { kind = otherSpec,  list = 0 }; };
+template<>           struct specKindOf<int>         { enum { kind = intSpec,    list = 0 }; };
+template<>           struct specKindOf<float>       { enum { kind = floatSpec,  list = 0 }; };
+template<>           struct specKindOf<bool>        { enum { kind = boolSpec,   list = 0 }; };
+template<>           struct specKindOf<std::string> { enum { kind = stringSpec, list = 0 }; };
+
+template <typename T, template <typename,typename...> class V, typename... Ps>
+struct specKindOf<V<T, Ps...> > { enum { kind = specKindOf<T>::kind, list = 1 }; };
+
+/** An option taking a value of type T, the arguments are as for option().
+*/
+template<typename T>
+constexpr optionSpec opt(const char* s_short, const char* s_long,
+                         const char* s_help, const char* s_default, unsigned s_flags = 0)
+  {
+  return optionSpec{s_short, s_long, s_help, s_default,
+                    specKindOf<T>::kind, specKindOf<T>::list != 0, true, s_flags};
+  }
+
+// A bool, true when the option is present.
+constexpr optionSpec flag(const char* s_short, const char* s_long,
+                          const char* s_help, unsigned s_flags = 0)
+  {
+  return optionSpec{s_short, s_long, s_help, nullptr, boolSpec, false, false, s_flags};
+  }
+
+// Compile time versions of the tests the fromString()'s make.
+
+constexpr bool specSpace(char c)
+  {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+  }
+
+constexpr char specLower(char c)
+  {
+  return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+  }
+
+constexpr bool specDigit(char c)
+  {
+  return c >= '0' && c <= '9';
+  }
+
+// Does s start with w, ignoring case?
+constexpr bool specPrefix(const char* s, const char* w)
+  {
+  while (*w)
+    if (specLower(*s++) != *w++)
+      return false;
+
+  return true;
+  }
+
+// The same as w, ignoring case?
+constexpr bool specIs(const char* s, const char* w)
+  {
+  while (*w)
+    if (specLower(*s++) != *w++)
+      return false;
+
+  return *s == '\0';
+  }
+
+constexpr bool specEqual(const char* a, const char* b)
+  {
+  if (a == nullptr || b == nullptr)
+    return a == b;
+
+  while (*a && *a == *b)
+    ++a, ++b;
+
+  return *a == *b;
+  }
+
+// Past the white space and sign strtol() and strtof() skip.
+constexpr const char* specNumber(const char* s)
+  {
+  while (specSpace(*s))
+    ++s;
+
+  if (*s == '+' || *s == '-')
+    ++s;
+
+  return s;
+  }
+
+constexpr bool specDefaultOk(const optionSpec &o)
+  {
+  if (o.d == nullptr)
+    return true;
+
+  const char* n = specNumber(o.d);
+
+  switch (o.kind)
+    {
+    case intSpec:
+      return specDigit(*n);
+
+    case floatSpec:
+      return specDigit(*n) || (*n == '.' && specDigit(n[1]))
+             || specPrefix(n, "inf") || specPrefix(n, "nan");
+
+    case boolSpec:
+      {
+      const char* words[] = {"1", "true", "yes", "enable", "0", "false", "no", "disable"};
+
+      for (const char* w: words)
+        if (specIs(o.d, w))
+          return true;
+      return false;
+      }
+
+    default:
+      return true;
+    }
+  }
+
+/* Each check returns the index of the first offending entry, or -1.
+*/
+
+template<std::size_t N>
+constexpr int specDuplicate(const optionSpec (&schema)[N])
+  {
+  for (std::size_t i = 0; i < N; ++i)
+    for (std::size_t j = 0; j < i; ++j)
+      {
+      const optionSpec &a = schema[i], &b = schema[j];
+
+      if ((a.s && specEqual(a.s, b.s)) || (a.l && specEqual(a.l, b.l))
+          || (!a.s && !a.l && !b.s && !b.l))
+        return (int)i;
+      }
+
+  return -1;
+  }
+
+template<std::size_t N>
+constexpr int specBadDefault(const optionSpec (&schema)[N])
+  {
+  for (std::size_t i = 0; i < N; ++i)
+    if (!specDefaultOk(schema[i]))
+      return (int)i;
+
+  return -1;
+  }
+
+template<std::size_t N>
+constexpr int specBoolArg(const optionSpec (&schema)[N])
+  {
+  for (std::size_t i = 0; i < N; ++i)
+    if (schema[i].kind == boolSpec && !schema[i].list && schema[i].hasArg)
+      return (int)i;
+
+  return -1;
+  }
+
+// Each fails to instantiate for a real index, so the compiler's message
+// says which entry is at fault.
+template<int index> struct duplicateNameAt
+  {
+  static_assert(index < 0, "duplicate short or long option name, or two positional options");
+  static constexpr bool ok = true;
+  };
+
+template<int index> struct badDefaultAt
+  {
+  static_assert(index < 0, "option default value isn't valid for the option's type");
+  static constexpr bool ok = true;
+  };
+
+template<int index> struct boolWithArgumentAt
+  {
+  static_assert(index < 0, "bool option declared with an argument, use flag()");
+  static constexpr bool ok = true;
+  };
+
+#define CMDLINEARG_CHECK_SCHEMA(S)                                                  \
+  static_assert(arguments::duplicateNameAt<arguments::specDuplicate(S)>::ok    \
+                && arguments::badDefaultAt<arguments::specBadDefault(S)>::ok   \
+                && arguments::boolWithArgumentAt<arguments::specBoolArg(S)>::ok, \
+                "option schema " #S)
+
+/** Declare entry I of schema S on args, for variable v.
+
+    @param args  The options object.
+    @param v     The variable, of the type the entry was made with.
+*/
+template<const optionSpec* S, int I, typename Options, typename T>
+int declare(Options &args, T &v)
+  {
+  static_assert(specKindOf<T>::kind == S[I].kind && (specKindOf<T>::list != 0) == S[I].list,
+                "variable type doesn't match its option schema entry");
+
+  return args.option(v, S[I].s, S[I].l, S[I].h, S[I].d, S[I].flags);
+  }
+
+} // namespace arguments
+
+//HH_CMDLINEARG_SCHEMA_HH
+#endif
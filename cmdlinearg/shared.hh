@@ -0,0 +1,333 @@
+/**
+  @file: shared.hh
+
+  @brief: Share one parsed set of options between forked (or exec'd) worker
+          processes, read only, through a single shared memory region.
+          (Linux only, uses memfd).
+
+arguments::sharedOptions freezes the values of a populated options object
+into a position independent block: offsets rather than pointers, numbers
+stored in binary, strings one after the other. The block lives in a sealed
+memfd mapped read only, so however many workers map it there's only one
+copy in memory, and workers never fault in private copies of the parent's
+containers.
+
+example usage :
+  ...
+
+  vector<string> hosts;       // Huge, from a response file say.
+  int threads;
+
+  int iHosts   = args.option(hosts, "H", "host", "Hosts to poll", nullptr );
+  int iThreads = args.option(threads, "t", "threads", "Worker threads", "4" );
+
+  args.populate(argc, argv);
+
+  arguments::sharedOptions shared;
+  shared.freeze(args);
+  hosts.clear();
+
+  for (int i = 0; i < workers; ++i)
+    if (fork() == 0)
+      {
+      int t = *shared.get<int>(iThreads);
+
+      for (std::size_t j = 0; j < shared.count(iHosts); ++j)
+        poll(shared.str(iHosts, j));
+      ...
+      }
+
+Options are found by index, as returned by option(). Single numbers and
+bools are read with get<T>(), lists of them with array<T>(), strings and
+lists of anything else with str(). Reading with the wrong type, one of
+another size or kind (get<float>() of an int, say), gives a nullptr.
+Options neither given nor defaulted are empty, as are those of types with
+neither a visitValue() nor a toString().
+
+A process started with exec() can be handed fd() and map the same block
+with attach().
+
+*/
+
+#ifndef HH_CMDLINEARG_SHARED_HH
+#define HH_CMDLINEARG_SHARED_HH
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cmdlinearg.hh"
+
+namespace arguments {
+
+// A position independent layout of values. Offsets are from the start of
+// the buffer.
+enum flatkind_e { noFlat = 0, scalarFlat, stringFlat, arrayFlat, stringsFlat };
+
+struct flatEntry
+  {
+  std::uint16_t kind, elem;   // flatkind_e and valueelem_e.
+  std::uint32_t size;         // Element size.
+  std::uint64_t n, off;       // Element count (or string length) and offset.
+  };
+
+struct flatWriter
+  {
+  std::string buf;
+
+  // Make room for n bytes on an 8 byte boundary, returning their offset.
+  std::uint64_t reserve(std::size_t n)
+    {
+    std::uint64_t off = (buf.size() + 7) & ~(std::uint64_t)7;
+
+    buf.resize(off + n);
+    return off;
+    }
+
+  std::uint64_t put(const void* p, std::size_t n)
+    {
+    std::uint64_t off = reserve(n);
+
+    if (n)
+      std::memcpy(&buf[off], p, n);
+    return off;
+    }
+  };
+
+// Lays out the value of one option (see argObjBase::visitMe()) in e.
+struct flattener : public valueVisitor
+  {
+  flatWriter &w;
+  flatEntry e;
+
+  flattener(flatWriter &_w) : w(_w), e{noFlat, noElem, 0, 0, 0} {};
+
+  virtual void number(const void* p, std::uint16_t elem, std::uint32_t size)
+    {
+    e = flatEntry{scalarFlat, elem, size, 1, w.put(p, size)};
+    }
+
+  virtual void numbers(const void* p, std::size_t n, std::uint16_t elem, std::uint32_t size)
+    {
+    e = flatEntry{arrayFlat, elem, size, n, w.put(p, n * size)};
+    }
+
+  // Followed by a '\0', which reserve() leaves.
+  virtual void string(const char* s, std::size_t n)
+    {
+    std::uint64_t off = w.reserve(n + 1);
+
+    if (n)
+      std::memcpy(&w.buf[off], s, n);
+    e = flatEntry{stringFlat, noElem, 1, n, off};
+    }
+
+  // The strings followed by a table of their offsets.
+  virtual void strings(const std::string &s, std::size_t n)
+    {
+    std::uint64_t chars = w.put(s.data(), s.size());
+    std::uint64_t off = w.reserve(n * 8);
+
+    for (std::uint64_t i = 0, p = 0; i < n; ++i, p += std::strlen(&s[p]) + 1)
+      {
+      std::uint64_t o = chars + p;
+      std::memcpy(&w.buf[off + i * 8], &o, 8);
+      }
+
+    e = flatEntry{stringsFlat, noElem, 8, n, off};
+    }
+
+  virtual void opaque() {}
+  };
+
+struct sharedOptions
+  {
+  // At offset 0, followed by one flatEntry per option index.
+  struct header
+    {
+    std::uint64_t magic, size, count;
+    };
+
+  static const std::uint64_t magic = 0x32746c6667726163ULL;   // "cargflt2"
+
+  const unsigned char* base;
+  std::size_t size;
+  int fd;
+
+  sharedOptions() : base(nullptr), size(0), fd(-1) {}
+  ~sharedOptions() { release(); }
+
+  sharedOptions(const sharedOptions&) = delete;
+  sharedOptions& operator=(const sharedOptions&) = delete;
+
+  void release()
+    {
+    if (base)
+      munmap(const_cast<unsigned char*>(base), size);
+    if (fd >= 0)
+      close(fd);
+    base = nullptr;
+    size = 0;
+    fd = -1;
+    }
+
+  /** Lay out the current values of args in a new shared region.
+
+      @param args  A populated options object.
+  */
+  template<typename Options>
+  bool freeze(const Options &args)
+    {
+    flatWriter w;
+    std::uint64_t count = args.options.empty() ? 0 : args.options.front()->index + 1;
+    std::uint64_t entries = w.reserve(sizeof(header)) + sizeof(header);
+
+    w.reserve(count * sizeof(flatEntry));
+
+    for (auto &a: args.options)
+      {
+      flattener f(w);
+
+      if (a->seen)
+        a->visitMe(f);
+      std::memcpy(&w.buf[entries + a->index * sizeof(flatEntry)], &f.e, sizeof(f.e));
+      }
+
+    header h{magic, w.buf.size(), count};
+    std::memcpy(&w.buf[0], &h, sizeof(h));
+
+    release();
+
+    int f = memfd_create("cmdlinearg", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    const char* p = w.buf.data();
+    const char* e = p + w.buf.size();
+    ssize_t n = 0;
+
+    while (f >= 0 && p < e && (n = write(f, p, e - p)) > 0)
+      p += n;
+
+    if (f < 0 || p != e
+        || fcntl(f, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0)
+      {
+      if (f >= 0)
+        close(f);
+      return false;
+      }
+
+    return attach(f);
+    }
+
+  // Map a region made by freeze(), perhaps in another process. Takes
+  // ownership of the descriptor, closing it if it can't be mapped.
+  bool attach(int f)
+    {
+    struct stat st;
+    header h;
+
+    release();
+    if (fstat(f, &st) != 0 || (std::size_t)st.st_size < sizeof(header))
+      {
+      close(f);
+      return false;
+      }
+
+    void* m = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, f, 0);
+
+    if (m == MAP_FAILED)
+      {
+      close(f);
+      return false;
+      }
+
+    std::memcpy(&h, m, sizeof(h));
+    if (h.magic != magic || h.size != (std::uint64_t)st.st_size
+        || sizeof(header) + h.count * sizeof(flatEntry) > h.size)
+      {
+      munmap(m, st.st_size);
+      close(f);
+      return false;
+      }
+
+    base = static_cast<const unsigned char*>(m);
+    size = st.st_size;
+    fd = f;
+    return true;
+    }
+
+  const header* head() const
+    {
+    return reinterpret_cast<const header*>(base);
+    }
+
+  // The layout of an option, or nullptr.
+  const flatEntry* entry(int index) const
+    {
+    if (base == nullptr || index < 0 || (std::uint64_t)index >= head()->count)
+      return nullptr;
+
+    return reinterpret_cast<const flatEntry*>(base + sizeof(header)) + index;
+    }
+
+  // A single number or bool.
+  template<typename T>
+  const T* get(int index) const
+    {
+    const flatEntry* e = entry(index);
+
+    if (e == nullptr || e->kind != scalarFlat || e->elem != valueElem<T>() || e->size != sizeof(T))
+      return nullptr;
+
+    return reinterpret_cast<const T*>(base + e->off);
+    }
+
+  // A list of numbers or bools, n is set to its length.
+  template<typename T>
+  const T* array(int index, std::size_t &n) const
+    {
+    const flatEntry* e = entry(index);
+
+    n = 0;
+    if (e == nullptr || e->kind != arrayFlat || e->elem != valueElem<T>() || e->size != sizeof(T))
+      return nullptr;
+
+    n = e->n;
+    return reinterpret_cast<const T*>(base + e->off);
+    }
+
+  // How many values an option holds.
+  std::size_t count(int index) const
+    {
+    const flatEntry* e = entry(index);
+
+    if (e == nullptr || e->kind == noFlat)
+      return 0;
+
+    return e->kind == stringFlat ? 1 : e->n;
+    }
+
+  // A string, or the i'th string of a list.
+  const char* str(int index, std::size_t i = 0) const
+    {
+    const flatEntry* e = entry(index);
+
+    if (e != nullptr && e->kind == stringFlat && i == 0)
+      return reinterpret_cast<const char*>(base + e->off);
+
+    if (e == nullptr || e->kind != stringsFlat || i >= e->n)
+      return nullptr;
+
+    const std::uint64_t* at = reinterpret_cast<const std::uint64_t*>(base + e->off);
+
+    return reinterpret_cast<const char*>(base + at[i]);
+    }
+  };
+
+} // namespace arguments
+
+//HH_CMDLINEARG_SHARED_HH
+#endif
@@ -0,0 +1,87 @@
+// toArgv() writes a command line that populates a fresh set of options to
+// the same values.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "cmdlinearg.hh"
+
+static int failures = 0;
+
+#define expect(x) \
+  do { if (!(x)) { std::printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #x); ++failures; } } while (0)
+
+struct settings
+  {
+  int threads = 0, level = 0;
+  float ratio = 0;
+  bool fast = false, safe = false;
+  std::string out;
+  std::vector<int> ports;
+  std::vector<std::string> files;
+  arguments::options<> args;
+
+  settings()
+    {
+    args.option(threads, "t", "threads", "Threads", "4");
+    args.option(level, "l", nullptr, "Level", "1");
+    args.option(ratio, "r", "ratio", "Ratio", "0.5");
+    args.option(fast, "f", "fast", "Go fast", "false");
+    args.option(safe, "s", "safe", "Be safe", "true");
+    args.option(out, "o", "out", "Output", "out.dat");
+    args.option(ports, "p", "port", "Ports", nullptr);
+    args.option(files, nullptr, nullptr, "Files", nullptr);
+    }
+
+  bool operator==(const settings &o) const
+    {
+    return threads == o.threads && level == o.level && ratio == o.ratio && fast == o.fast
+        && safe == o.safe && out == o.out && ports == o.ports && files == o.files;
+    }
+
+  // Populate from what toArgv() gives.
+  bool from(const settings &o, bool all, std::vector<std::string> &words)
+    {
+    std::string buf;
+    std::vector<char*> argv;
+
+    o.args.toArgv(buf, argv, "prog", all);
+    words.assign(argv.begin(), argv.end() - 1);
+
+    std::vector<const char*> in(argv.begin(), argv.end() - 1);
+    return argv.back() == nullptr && args.populate((int)in.size(), in.data()).isOk();
+    }
+  };
+
+int main()
+  {
+  std::vector<std::string> words;
+
+  // Nothing but defaults gives just the program name, unless asked.
+  settings plain, plainCopy, plainAll;
+  const char* none[] = {"prog"};
+
+  expect(plain.args.populate(1, none).isOk());
+  expect(plainCopy.from(plain, false, words) && plainCopy == plain);
+  expect(words == std::vector<std::string>({"prog"}));
+  expect(plainAll.from(plain, true, words) && plainAll == plain && words.size() > 1);
+
+  settings given, copy;
+  const char* argv[] = {"prog", "-t", "8", "-l", "3", "--ratio=0.25", "-f", "--safe=false",
+                        "-o", "a file", "-p", "80", "-p", "443", "x", "-", "-y", ""};
+
+  expect(given.args.populate(18, argv).isOk());
+  expect(copy.from(given, false, words) && copy == given);
+  expect(copy.threads == 8 && copy.level == 3 && copy.fast && !copy.safe);
+  expect(copy.files == std::vector<std::string>({"x", "-y", ""}));
+
+  // Once more from the copy gives the same command line.
+  settings again;
+  std::vector<std::string> first = words;
+
+  expect(again.from(copy, false, words) && again == given && words == first);
+
+  return failures != 0;
+  }
@@ -0,0 +1,131 @@
+// Values given checks in option(): rejected values must not be kept, in
+// lists, single values or overlays.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "cmdlinearg.hh"
+#include "overlay.hh"
+
+static int failures = 0;
+
+#define expect(x) \
+  do { if (!(x)) { std::printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #x); ++failures; } } while (0)
+
+static void scalars()
+  {
+  int c = 0;
+  std::string mode;
+  arguments::options<> args;
+
+  args.option(c, "c", "count", "Count", "8", 0, arguments::inRange(1, 64));
+  args.option(mode, "m", "mode", "Mode", "fast", 0, arguments::oneOf({"fast", "small"}));
+
+  const char* good[] = {"prog", "-c", "12", "--mode", "small"};
+  expect(args.populate(5, good).isOk());
+  expect(c == 12);
+  expect(mode == "small");
+
+  const char* bad[] = {"prog", "-c", "1000", "--mode", "huge"};
+  expect(args.populate(3, bad).state == arguments::invalid);
+  expect(c == 12);
+  }
+
+// A default that fails its checks is reported, with errors collected or not.
+static void defaults()
+  {
+  const char* none[] = {"prog"};
+  int c = 5;
+  arguments::options<> plain, collect;
+  std::vector<arguments::errorState> errors;
+
+  plain.option(c, "c", "count", "Count", "100", 0, arguments::inRange(1, 64));
+  collect.option(c, "c", "count", "Count", "100", 0, arguments::inRange(1, 64));
+
+  expect(plain.populate(1, none).state == arguments::invalid);
+  expect(c == 5);
+  expect(collect.populate(1, none, errors).state == arguments::invalid);
+  expect(errors.size() == 1);
+  }
+
+static void lists()
+  {
+  std::vector<int> sizes;
+  std::vector<bool> flags;
+  arguments::options<> args;
+
+  args.option(sizes, "s", "size", "Sizes", nullptr, 0, arguments::inRange(1, 10), arguments::atMost(3));
+  args.option(flags, "f", "flag", "Flags", nullptr, 0,
+              arguments::satisfies([](bool b) { return b; }));
+
+  const char* good[] = {"prog", "-s", "1", "-s", "2", "-f", "true", "-f", "1"};
+  expect(args.populate(9, good).isOk());
+  expect(sizes.size() == 2 && sizes[1] == 2);
+  expect(flags.size() == 2 && flags[0] && flags[1]);
+
+  // populate() appends to lists as they are.
+  sizes.clear();
+  flags.clear();
+
+  const char* range[] = {"prog", "-s", "1", "-s", "11"};
+  expect(args.populate(5, range).state == arguments::invalid);
+  expect(sizes.size() == 1 && sizes[0] == 1);
+
+  sizes.clear();
+
+  const char* count[] = {"prog", "-s", "1", "-s", "2", "-s", "3", "-s", "4"};
+  expect(args.populate(9, count).state == arguments::invalid);
+  expect(sizes.size() == 3);
+
+  const char* bools[] = {"prog", "-f", "true", "-f", "false"};
+  expect(args.populate(5, bools).state == arguments::invalid);
+  expect(flags.size() == 1 && flags[0]);
+  }
+
+static void overlays()
+  {
+  int c = 0;
+  std::vector<int> sizes;
+  arguments::options<> args;
+
+  int iC = args.option(c, "c", "count", "Count", "8", 0, arguments::inRange(1, 64));
+  int iSizes = args.option(sizes, "s", "size", "Sizes", nullptr, 0, arguments::inRange(1, 10));
+
+  const char* none[] = {"prog"};
+  expect(args.populate(1, none).isOk());
+
+  // A first override that fails leaves the base value showing.
+  arguments::overlay<arguments::options<> > first(args);
+  const char* rejected[] = {"-c", "100"};
+  const char* unconverted[] = {"-c", "abc"};
+  expect(first.apply(2, rejected).state == arguments::invalid);
+  expect(first.apply(2, unconverted).state == arguments::invalid);
+  expect(!first.has(iC) && first.get(iC, c) == 8);
+  expect(first.n == 0 && first.used == 0);
+
+  arguments::overlay<arguments::options<> > o(args);
+  const char* good[] = {"-c", "3", "-s", "4"};
+  expect(o.apply(4, good).isOk());
+  expect(o.get(iC, c) == 3);
+  expect(o.get(iSizes, sizes).size() == 1);
+
+  const char* bad[] = {"-c", "100"};
+  expect(o.apply(2, bad).state == arguments::invalid);
+  expect(o.get(iC, c) == 3);
+
+  const char* badList[] = {"-s", "40"};
+  expect(o.apply(2, badList).state == arguments::invalid);
+  expect(o.get(iSizes, sizes).size() == 1);
+  expect(c == 8);
+  }
+
+int main()
+  {
+  scalars();
+  defaults();
+  lists();
+  overlays();
+
+  return failures != 0;
+  }
@@ -0,0 +1,112 @@
+// The vectorised hex and base64 decoders against the scalar ones, over
+// valid input of every length up to a few blocks and the same with a bad
+// character put in at each position.
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bytes.hh"
+
+static int failures = 0;
+
+#define expect(x) \
+  do { if (!(x)) { std::printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #x); ++failures; } } while (0)
+
+// Decode s with f and with the scalar decoder, which must agree on the
+// bytes and on the offending character, if any. Output is sized exactly.
+static void compare(const char* name, arguments::decoder_f f, arguments::decoder_f scalar,
+                    const std::string &s, std::size_t outSize)
+  {
+  std::vector<unsigned char> a(outSize), b(outSize);
+  const char* ea = f(a.empty() ? nullptr : &a[0], s.data(), s.size());
+  const char* eb = scalar(b.empty() ? nullptr : &b[0], s.data(), s.size());
+
+  if (ea != eb || (eb == nullptr && a != b))
+    {
+    std::printf("%s: '%s' differs from scalar\n", name, s.c_str());
+    ++failures;
+    }
+  }
+
+static void decoders(const char* name, arguments::decoder_f f, bool base64)
+  {
+  static const char hex[] = "0123456789abcdefABCDEF";
+  static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  static const char bad[] = "!-=@[`{: \x80\xff";   // Neither hex nor base64.
+  std::mt19937 rng(51);
+
+  for (std::size_t n = 0; n <= 200; ++n)
+    {
+    if (base64 ? n % 4 == 1 : n % 2 == 1)
+      continue;
+
+    std::size_t outSize = base64 ? n / 4 * 3 + (n % 4 ? n % 4 - 1 : 0) : n / 2;
+    std::string s;
+
+    for (std::size_t i = 0; i < n; ++i)
+      s.push_back(base64 ? b64[rng() % 64] : hex[rng() % 22]);
+
+    compare(name, f, base64 ? arguments::base64DecodeScalar : arguments::hexDecodeScalar, s, outSize);
+
+    for (std::size_t i = 0; i < n; ++i)
+      {
+      std::string t(s);
+
+      t[i] = bad[rng() % (sizeof(bad) - 1)];
+      compare(name, f, base64 ? arguments::base64DecodeScalar : arguments::hexDecodeScalar, t, outSize);
+      }
+    }
+  }
+
+// Whole values, through fromString() and back with toString().
+static void roundTrip()
+  {
+  std::mt19937 rng(7);
+
+  for (std::size_t n = 0; n <= 100; ++n)
+    {
+    arguments::hexBytes<> h, h2;
+    arguments::base64Bytes<> b, b2;
+    std::string hs, bs;
+    const char* at = nullptr;
+
+    for (std::size_t i = 0; i < n; ++i)
+      h.push_back((unsigned char)rng());
+    b.assign(h.begin(), h.end());
+
+    arguments::toString(hs, h);
+    arguments::toString(bs, b);
+
+    expect(fromString(h2, hs.c_str(), at) && h2 == h);
+    expect(fromString(b2, bs.c_str(), at) && b2 == b);
+    }
+  }
+
+int main()
+  {
+  roundTrip();
+
+#ifdef CMDLINEARG_X86_SIMD
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("ssse3"))
+    {
+    decoders("hexDecodeSSSE3", arguments::hexDecodeSSSE3, false);
+    decoders("base64DecodeSSSE3", arguments::base64DecodeSSSE3, true);
+    }
+  else
+    std::printf("no SSSE3, its decoders not tested\n");
+
+  if (__builtin_cpu_supports("avx2"))
+    {
+    decoders("hexDecodeAVX2", arguments::hexDecodeAVX2, false);
+    decoders("base64DecodeAVX2", arguments::base64DecodeAVX2, true);
+    }
+  else
+    std::printf("no AVX2, its decoders not tested\n");
+#endif
+
+  return failures != 0;
+  }
@@ -0,0 +1,103 @@
+// Options flagged memoize: cached values must be what a fresh conversion
+// gives, and only successful conversions are cached.
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "cmdlinearg.hh"
+
+static int failures = 0;
+
+#define expect(x) \
+  do { if (!(x)) { std::printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #x); ++failures; } } while (0)
+
+// A number that counts its conversions.
+struct counted
+  {
+  long v;
+
+  static int conversions;
+
+  bool operator==(const counted &o) const { return v == o.v; }
+  };
+
+int counted::conversions = 0;
+
+bool fromString(counted &c, const char* s)
+  {
+  char* e;
+
+  ++counted::conversions;
+  c.v = std::strtol(s, &e, 0);
+  return e != s && *e == '\0';
+  }
+
+static void cached()
+  {
+  counted c{0}, fresh{0};
+  arguments::options<> args;
+
+  args.option(c, "c", "count", "Count", nullptr, arguments::memoize);
+
+  const char* once[] = {"prog", "-c", "0x20"};
+  expect(args.populate(3, once).isOk() && c.v == 32 && counted::conversions == 1);
+
+  c.v = 0;
+  expect(args.populate(3, once).isOk() && counted::conversions == 1);
+  expect(fromString(fresh, "0x20") && c == fresh);
+
+  // Other strings for the same value are converted, and cached, apart.
+  const char* other[] = {"prog", "-c", "32"};
+  counted::conversions = 0;
+  expect(args.populate(3, other).isOk() && c.v == 32 && counted::conversions == 1);
+  expect(args.populate(3, other).isOk() && counted::conversions == 1);
+  }
+
+static void failed()
+  {
+  int n = 0;
+  counted c{0};
+  arguments::options<> args;
+
+  args.option(n, "n", "number", "Number", nullptr, arguments::memoize);
+  args.option(c, "c", "count", "Count", nullptr, arguments::memoize);
+
+  const char* bad[] = {"prog", "-n", "x12"};
+  expect(args.populate(3, bad).state == arguments::invalid);
+  expect(args.populate(3, bad).state == arguments::invalid);
+
+  const char* worse[] = {"prog", "-c", "x"};
+  counted::conversions = 0;
+  expect(args.populate(3, worse).state == arguments::invalid);
+  expect(args.populate(3, worse).state == arguments::invalid);
+  expect(counted::conversions == 2);
+  }
+
+static void lists()
+  {
+  std::vector<counted> cs;
+  std::vector<std::string> names;
+  arguments::options<> args;
+
+  args.option(cs, "c", "count", "Counts", nullptr, arguments::memoize);
+  args.option(names, "s", "name", "Names", nullptr, arguments::memoize);
+
+  const char* argv[] = {"prog", "-c", "5", "-c", "6", "-c", "5", "-c", "5",
+                        "-s", "a", "-s", "a", "-s", "b"};
+  counted::conversions = 0;
+  expect(args.populate(15, argv).isOk());
+  expect(counted::conversions == 2);
+  expect(cs.size() == 4 && cs[0].v == 5 && cs[1].v == 6 && cs[2].v == 5 && cs[3].v == 5);
+  expect(names == std::vector<std::string>({"a", "a", "b"}));
+  }
+
+int main()
+  {
+  cached();
+  failed();
+  lists();
+
+  return failures != 0;
+  }
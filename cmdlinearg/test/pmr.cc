@@ -0,0 +1,104 @@
+// std::pmr options given a memory resource: their values, and the growth of
+// lists, are allocated from it and nowhere else.
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <memory_resource>
+
+#include "cmdlinearg.hh"
+
+static int failures = 0;
+
+#define expect(x) \
+  do { if (!(x)) { std::printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #x); ++failures; } } while (0)
+
+// An arena that counts what it hands out, and can tell its own memory.
+struct arena : public std::pmr::memory_resource
+  {
+  alignas(std::max_align_t) unsigned char buf[1 << 16];
+  std::pmr::monotonic_buffer_resource mono;
+  std::size_t allocations;
+
+  arena() : mono(buf, sizeof(buf), std::pmr::null_memory_resource()), allocations(0) {}
+
+  bool owns(const void* p) const
+    {
+    const unsigned char* c = static_cast<const unsigned char*>(p);
+
+    return c >= buf && c < buf + sizeof(buf);
+    }
+
+  void* do_allocate(std::size_t n, std::size_t align) override
+    {
+    ++allocations;
+    return mono.allocate(n, align);
+    }
+
+  void do_deallocate(void* p, std::size_t n, std::size_t align) override
+    {
+    mono.deallocate(p, n, align);
+    }
+
+  bool do_is_equal(const std::pmr::memory_resource &o) const noexcept override
+    {
+    return this == &o;
+    }
+  };
+
+int main()
+  {
+  std::pmr::string name;
+  std::pmr::vector<std::pmr::string> tags;
+  std::pmr::vector<int> sizes;
+  std::string plain;
+  arena a;
+
+  arguments::options<> args;
+
+  args.option(name, "n", "name", "A name", nullptr);
+  args.option(tags, "t", "tag", "Tags", nullptr);
+  args.option(sizes, "s", "size", "Sizes", nullptr);
+  args.option(plain, "p", "plain", "Not pmr", nullptr);
+
+  std::vector<std::string> given = {"prog", "--name", "a name too long to be kept inline",
+                                    "--plain", "left on the heap, as it always was"};
+
+  for (int i = 0; i < 40; ++i)
+    {
+    given.push_back("-t");
+    given.push_back("tag number " + std::to_string(i) + ", again too long to be inline");
+    given.push_back("-s");
+    given.push_back(std::to_string(i));
+    }
+
+  std::vector<const char*> argv;
+
+  for (auto &g: given)
+    argv.push_back(g.c_str());
+
+  // Anything allocated from the default resource instead fails.
+  std::pmr::memory_resource* was = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+  arguments::errorState r = arguments::populate(args, &a, (int)argv.size(), argv.data());
+  std::pmr::set_default_resource(was);
+
+  expect(r.isOk());
+  expect(name == "a name too long to be kept inline" && tags.size() == 40 && sizes.size() == 40);
+  expect(name.get_allocator().resource() == &a && a.owns(name.data()));
+  expect(tags.get_allocator().resource() == &a && a.owns(tags.data()));
+  expect(sizes.get_allocator().resource() == &a && a.owns(sizes.data()));
+  expect(sizes[39] == 39);
+  expect(!a.owns(plain.data()));
+
+  bool all = true;
+
+  for (auto &t: tags)
+    all = all && t.get_allocator().resource() == &a && a.owns(t.data());
+  expect(all);
+
+  // One each for name, the tags and their growth, the sizes' growth.
+  expect(a.allocations > 1 + 40 + 2);
+
+  return failures != 0;
+  }
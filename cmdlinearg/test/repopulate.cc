@@ -0,0 +1,115 @@
+// repopulate() re-converts only the options whose values changed, and if
+// any value (or default) fails, touches nothing at all.
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "cmdlinearg.hh"
+
+static int failures = 0;
+
+#define expect(x) \
+  do { if (!(x)) { std::printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #x); ++failures; } } while (0)
+
+typedef arguments::options<> options_t;
+
+struct server
+  {
+  int threads = 0, port = 0;
+  std::string name;
+  std::vector<int> ids;
+  options_t args;
+  std::vector<options_t::argObjBase*> changed;
+
+  server(unsigned flags)
+    {
+    args.option(threads, "t", "threads", "Threads", "4", flags);
+    args.option(port, "p", "port", "Port", "80", flags, arguments::inRange(1, 65535));
+    args.option(name, "n", "name", "Name", "x", flags);
+    args.option(ids, "i", "id", "Ids", nullptr, flags);
+    }
+
+  bool changes(std::initializer_list<const char*> names) const
+    {
+    std::vector<std::string> got, want(names.begin(), names.end());
+
+    for (auto a: changed)
+      got.push_back(a->l);
+    std::sort(got.begin(), got.end());
+    std::sort(want.begin(), want.end());
+    return got == want;
+    }
+  };
+
+static void changes()
+  {
+  server s(arguments::keepRaw);
+  const char* first[] = {"prog", "-t", "8", "-i", "1", "-i", "2"};
+  const char* same[] = {"prog", "-i", "1", "-i", "2", "-t", "8"};
+  const char* more[] = {"prog", "-t", "8", "-i", "1", "-i", "2", "-i", "3", "-p", "8080"};
+  const char* fewer[] = {"prog", "-i", "1"};
+
+  expect(s.args.populate(7, first).isOk());
+  expect(s.args.repopulate(7, same, s.changed).isOk() && s.changes({}));
+  expect(s.args.repopulate(11, more, s.changed).isOk() && s.changes({"id", "port"}));
+  expect(s.ids == std::vector<int>({1, 2, 3}) && s.port == 8080);
+
+  // Options no longer given go back to their defaults.
+  expect(s.args.repopulate(3, fewer, s.changed).isOk() && s.changes({"threads", "id", "port"}));
+  expect(s.threads == 4 && s.port == 80 && s.ids == std::vector<int>({1}));
+  }
+
+static void first()
+  {
+  // Options not flagged keepRaw are all re-converted the first time.
+  server s(0);
+  const char* argv[] = {"prog", "-t", "8", "-n", "a"};
+
+  expect(s.args.populate(5, argv).isOk());
+  expect(s.args.repopulate(5, argv, s.changed).isOk() && s.changes({"threads", "port", "name", "id"}));
+  expect(s.threads == 8 && s.name == "a" && s.port == 80);
+  expect(s.args.repopulate(5, argv, s.changed).isOk() && s.changes({}));
+  }
+
+static void rollback()
+  {
+  server s(arguments::keepRaw);
+  const char* good[] = {"prog", "-t", "8", "-n", "a", "-i", "5"};
+  const char* bad[] = {"prog", "-t", "16", "-n", "b", "-i", "6", "-p", "70000"};
+  const char* unknown[] = {"prog", "-t", "16", "--nope"};
+
+  expect(s.args.populate(7, good).isOk());
+
+  arguments::errorState r = s.args.repopulate(9, bad, s.changed);
+  expect(r.state == arguments::invalid && s.changed.empty());
+  expect(s.threads == 8 && s.name == "a" && s.ids == std::vector<int>({5}) && s.port == 80);
+
+  r = s.args.repopulate(4, unknown, s.changed);
+  expect(r.state == arguments::unknown && s.changed.empty() && s.threads == 8);
+
+  // Nothing was taken from either, so the same values are still unchanged.
+  expect(s.args.repopulate(7, good, s.changed).isOk() && s.changes({}));
+
+  // A default that fails its checks rolls back too.
+  for (auto a: s.args.options)
+    if (std::string(a->l) == "port")
+      a->d = "0";
+
+  const char* dropPort[] = {"prog", "-t", "16", "-p", "81"};
+  expect(s.args.repopulate(5, dropPort, s.changed).isOk() && s.port == 81 && s.threads == 16);
+
+  r = s.args.repopulate(3, good, s.changed);
+  expect(r.state == arguments::invalid && std::string(r.op) == "port" && s.changed.empty());
+  expect(s.threads == 16 && s.port == 81 && s.name == "x" && s.ids.empty());
+  }
+
+int main()
+  {
+  changes();
+  first();
+  rollback();
+
+  return failures != 0;
+  }
@@ -0,0 +1,77 @@
+// Every way of populating keeps only this worker's shard of the positional
+// values.
+
+#include <cstdio>
+#include <future>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "cmdlinearg.hh"
+#include "async.hh"
+
+static int failures = 0;
+
+#define expect(x) \
+  do { if (!(x)) { std::printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #x); ++failures; } } while (0)
+
+struct worker
+  {
+  arguments::shard mine;
+  std::vector<std::string> files;
+  arguments::options<> args;
+
+  worker()
+    {
+    args.shardOption(mine, nullptr, "shard", "This worker's share");
+    args.option(files, nullptr, nullptr, "Files", nullptr);
+    }
+
+  bool got(std::initializer_list<const char*> want) const
+    {
+    return files == std::vector<std::string>(want.begin(), want.end());
+    }
+  };
+
+static const char* argv[] = {"prog", "a", "b", "c", "--shard", "1/2", "d", "e", "-", "f"};
+static const int argc = sizeof(argv) / sizeof(argv[0]);
+
+int main()
+  {
+  worker all;
+  const char* none[] = {"prog", "a", "b"};
+  expect(all.args.populate(3, none).isOk() && all.got({"a", "b"}));
+
+  worker p;
+  expect(p.args.populate(argc, argv).isOk() && p.got({"b", "d", "f"}));
+  expect(p.mine.i == 1 && p.mine.n == 2);
+
+  worker k;
+  std::vector<int> rest;
+  expect(k.args.populateKnown(argc, argv, rest).isOk() && k.got({"b", "d", "f"}));
+  expect(k.args.populateRest(argv, rest).isOk() && k.got({"b", "d", "f"}));
+
+  // A value set aside with an unknown option turns out to be positional,
+  // and is counted after those populateKnown() kept, where it stopped.
+  worker late;
+  bool flag = false;
+  const char* plugin[] = {"prog", "a", "b", "--later", "c", "d", "--shard", "1/2"};
+  expect(late.args.populateKnown(8, plugin, rest).isOk() && late.got({"b"}));
+  expect(late.args.addOptions([&flag](arguments::options<> &o)
+                               { o.option(flag, nullptr, "later", "A plugin's flag", nullptr); }).isOk());
+  expect(late.args.populateRest(plugin, rest).isOk() && flag && late.got({"b", "c"}));
+
+  worker r;
+  std::vector<arguments::options<>::argObjBase*> changed;
+  expect(r.args.populate(argc, argv).isOk());
+  const char* again[] = {"prog", "--shard", "0/2", "x", "y", "z"};
+  r.files.clear();
+  expect(r.args.repopulate(6, again, changed).isOk() && r.got({"x", "z"}));
+
+  worker a;
+  std::future<arguments::errorState> later;
+  expect(arguments::populateAsync(a.args, argc, argv, later).isOk());
+  expect(later.get().isOk() && a.got({"b", "d", "f"}));
+
+  return failures != 0;
+  }
@@ -0,0 +1,106 @@
+// splitWords() splits as sh would, and populateLine() reuses its words
+// between calls.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "cmdlinearg.hh"
+
+static int failures = 0;
+
+#define expect(x) \
+  do { if (!(x)) { std::printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #x); ++failures; } } while (0)
+
+static std::vector<std::string> split(const char* s, bool &closed)
+  {
+  std::string buf(s);
+  std::vector<const char*> words;
+
+  closed = arguments::splitWords(&buf[0], buf.size(), words);
+  return std::vector<std::string>(words.begin(), words.end());
+  }
+
+static bool same(const char* s, std::initializer_list<const char*> want)
+  {
+  bool closed;
+
+  return split(s, closed) == std::vector<std::string>(want.begin(), want.end()) && closed;
+  }
+
+static void words()
+  {
+  bool closed;
+
+  expect(same("", {}));
+  expect(same("  \t\n ", {}));
+  expect(same(" a  bc\td\n", {"a", "bc", "d"}));
+
+  // Single quotes keep everything, backslashes and double quotes included.
+  expect(same("'a b' 'c\\d' '\"'", {"a b", "c\\d", "\""}));
+  expect(same("x'y z'w", {"xy zw"}));
+  expect(same("''", {""}));
+
+  // Double quotes keep white space and single quotes, a backslash only
+  // escapes \ " $ ` and a new line.
+  expect(same("\"a b\" \"it's\" \"\\\"q\\\"\" \"\\n\"", {"a b", "it's", "\"q\"", "\\n"}));
+  expect(same("\"a\\\nb\"", {"ab"}));
+
+  // Outside quotes a backslash escapes anything, a new line joins lines.
+  expect(same("a\\ b \\'c \\\\", {"a b", "'c", "\\"}));
+  expect(same("a\\\nb", {"ab"}));
+
+  expect(split("a 'b c", closed).size() == 2 && !closed);
+  expect(split("\"a", closed).size() == 1 && !closed);
+  expect(!split("a\\\"\"", closed).empty() && !closed);
+  }
+
+// What a job server parses each command into.
+struct job
+  {
+  int n = 0;
+  std::string name;
+  std::vector<std::string> files;
+  arguments::options<> args;
+
+  job()
+    {
+    args.option(n, "n", "number", "A number", "1");
+    args.option(name, nullptr, "name", "A name", "none");
+    args.option(files, nullptr, nullptr, "Files", nullptr);
+    }
+  };
+
+static void lines()
+  {
+  std::vector<const char*> words;
+  char first[] = "prog -n 3 --name 'a b' x \"y z\"";
+  char second[] = "prog -n 4 y";
+  char open[] = "prog -n 5 --name 'a";
+
+  job one;
+  expect(one.args.populateLine(first, std::strlen(first), words).isOk());
+  expect(one.n == 3 && one.name == "a b" && one.files == std::vector<std::string>({"x", "y z"}));
+
+  // The same words again, their room already there.
+  std::size_t room = words.capacity();
+
+  job two;
+  expect(two.args.populateLine(second, std::strlen(second), words).isOk());
+  expect(two.n == 4 && two.name == "none" && two.files == std::vector<std::string>({"y"}));
+  expect(words.capacity() == room && words.size() == 4);
+
+  // Nothing is populated from a line with a quote left open.
+  job three;
+  arguments::errorState r = three.args.populateLine(open, std::strlen(open), words);
+  expect(r.state == arguments::invalid && r.arg == 4 && three.n == 0);
+  }
+
+int main()
+  {
+  words();
+  lines();
+
+  return failures != 0;
+  }
@@ -0,0 +1,263 @@
+/**
+  @file: tree.hh
+
+  @brief: Hierarchical option names, such as --db.pool.size, kept in a tree
+          of name segments, with operations on whole groups.
+
+An arguments::optionTree sits beside an options object. Options declared
+through it get a dotted long name and a place in the tree, one node per
+segment. Looking up a long option then takes one step per segment rather
+than a scan of every option, and everything under a group ('db.pool',
+say, or '' for all of them) can be listed, reset to its defaults, dumped,
+or set from (name, value) pairs relative to the group.
+
+example usage :
+  ...
+
+  arguments::options<> args;
+  arguments::optionTree<> tree(args);
+
+  tree.option(poolSize, nullptr, "db.pool.size", "Connections", "8" );
+  tree.option(poolTimeout, nullptr, "db.pool.timeout", "Seconds", "30" );
+  tree.option(l2Bytes, nullptr, "cache.l2.bytes", "L2 cache size", "1048576" );
+
+  args.populate(argc, argv);     // --db.pool.size 16 ...
+
+  ...
+  // Reconfigure one subsystem:
+  tree.reset("db");
+  tree.set("db.pool", {{"size", "32"}, {"timeout", "5"}});
+  tree.dump(std::cout, "db");    // --db.pool.size 32 ...
+
+Short names, and options declared on args directly, are still found the
+usual way. dump() writes one option and value per line, the format read by
+reloadable (see reload.hh), so values can't contain white space.
+
+*/
+
+#ifndef HH_CMDLINEARG_TREE_HH
+#define HH_CMDLINEARG_TREE_HH
+
+#include <algorithm>
+#include <cstring>
+#include <forward_list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cmdlinearg.hh"
+
+namespace arguments {
+
+template<typename Options = options<> >
+struct optionTree : public Options::optionLookup
+  {
+  typedef typename Options::argObjBase argObjBase;
+
+  struct node
+    {
+    std::map<std::string, int> kids;   // Segment to node.
+    argObjBase* a;                      // The option named here, if any.
+    };
+
+  Options &args;
+  std::vector<node> nodes;                // nodes[0] is the root.
+  std::forward_list<std::string> names;   // Owns the long names given args.
+
+  explicit optionTree(Options &_args) : args(_args), nodes(1, node{{}, nullptr})
+    {
+    args.lookup = this;
+    }
+
+  ~optionTree()
+    {
+    if (args.lookup == this)
+      args.lookup = nullptr;
+    }
+
+  optionTree(const optionTree&) = delete;
+  optionTree& operator=(const optionTree&) = delete;
+
+  /** Register an option with a hierarchical long name, as args.option().
+
+      @s_path the long name, segments separated by '.' (i.e. 'db.pool.size')
+      @return the option's index, its order of declaration from 0, or -1
+              (and nothing declared) if the path is empty or already taken.
+  */
+  template<typename T>
+  int option(T &variable, const char* s_short, const char* s_path,
+             const char* s_help, const char* s_default, unsigned s_flags = 0)
+    {
+    int n = 0;
+
+    for (const char* p = s_path; *p; )
+      {
+      const char* e = p;
+
+      while (*e && *e != '.')
+        ++e;
+
+      auto k = nodes[n].kids.insert(std::make_pair(std::string(p, e), (int)nodes.size()));
+
+      if (k.second)
+        nodes.push_back(node{{}, nullptr});
+
+      n = k.first->second;
+      p = *e ? e + 1 : e;
+      }
+
+    if (n == 0 || nodes[n].a != nullptr)
+      return -1;
+
+    names.push_front(s_path);
+
+    int i = args.option(variable, s_short, names.front().c_str(), s_help, s_default, s_flags);
+
+    nodes[n].a = args.options.front();
+    return i;
+    }
+
+  // Follow path from node n, stopping at a delimiter, after which d points.
+  // Returns the node reached, or -1.
+  int walk(int n, const char* p, const char* &d) const
+    {
+    d = nullptr;
+
+    while (n >= 0 && *p)
+      {
+      const char* e = p;
+
+      while (*e && *e != '.' && !Options::isDelim(*e))
+        ++e;
+
+      auto k = nodes[n].kids.find(std::string(p, e));
+
+      n = (k == nodes[n].kids.end()) ? -1 : k->second;
+
+      if (*e != '\0' && *e != '.')
+        {
+        d = e + 1;
+        break;
+        }
+
+      p = *e ? e + 1 : e;
+      }
+
+    return n;
+    }
+
+  virtual argObjBase* find(const char* &d, const char* s, int sl) const
+    {
+    int n = sl ? -1 : walk(0, s, d);
+
+    return n > 0 ? nodes[n].a : nullptr;
+    }
+
+  /** Call f(option) for every option in a group, including any named by
+      the group itself, in name order.
+
+      @param group  e.g. 'db.pool', '' for all.
+      @return false if there's no such group.
+  */
+  template<typename F>
+  bool forEach(const char* group, F f) const
+    {
+    const char* d;
+    int g = walk(0, group, d);
+
+    if (g < 0 || d)
+      return false;
+
+    std::vector<int> todo(1, g);
+
+    while (!todo.empty())
+      {
+      const node &x = nodes[todo.back()];
+
+      todo.pop_back();
+      if (x.a)
+        f(x.a);
+
+      for (auto k = x.kids.rbegin(); k != x.kids.rend(); ++k)
+        todo.push_back(k->second);
+      }
+
+    return true;
+    }
+
+  // Put every option in a group back to its default (or empty, unseen).
+  bool reset(const char* group)
+    {
+    return forEach(group, [](argObjBase* a)
+      {
+      a->reset();
+      if (a->d)
+        a->setMe(a->d);
+      });
+    }
+
+  /** Write the current values of a group's options, one '--name value' per
+      line. Bools are only given when true, options never given and
+      without a default not at all.
+  */
+  template<typename O>
+  bool dump(O &os, const char* group) const
+    {
+    std::string vals;
+
+    return forEach(group, [&os, &vals](argObjBase* a)
+      {
+      vals.clear();
+      int n = a->getMe(vals);
+
+      for (const char* v = vals.data(); n-- > 0; v += std::strlen(v) + 1)
+        if (a->numArgs() != 0)
+          os << "--" << a->l << " " << v << "\n";
+        else if (std::strcmp(v, "true") == 0)
+          os << "--" << a->l << "\n";
+      });
+    }
+
+  /** Set options in a group from (name, value) pairs, the names relative
+      to the group (i.e. 'pool.size' in group 'db'), so the group is only
+      looked up once. As on the command line a list collects all of its
+      values, but the first replaces what it held before. Stops at the
+      first error, the settings before it are kept (see reloadable::set()
+      for all or nothing).
+  */
+  errorState set(const char* group, const std::vector<std::pair<const char*, const char*> > &batch)
+    {
+    const char* d;
+    int g = walk(0, group, d);
+    std::vector<argObjBase*> done;
+
+    if (g < 0 || d)
+      return errorState{unknown, group, nullptr, nullptr, 0};
+
+    for (auto &kv: batch)
+      {
+      int n = walk(g, kv.first, d);
+      argObjBase* a = (n < 0 || d) ? nullptr : nodes[n].a;
+
+      if (a == nullptr)
+        return errorState{unknown, kv.first, nullptr, nullptr, 0};
+
+      if (std::find(done.begin(), done.end(), a) == done.end())
+        {
+        a->reset();
+        done.push_back(a);
+        }
+
+      if (!a->setMe(kv.second))
+        return errorState{invalid, a->l, kv.second, a->at, 0};
+      }
+
+    return errorState{ok, nullptr, nullptr, nullptr, 0};
+    }
+  };
+
+} // namespace arguments
+
+//HH_CMDLINEARG_TREE_HH
+#endif
@@ -0,0 +1,283 @@
+/**
+  @file: usage.hh
+
+  @brief: Count which options are actually used, across every run of a
+          program, in a small memory mapped file. (POSIX, uses mmap).
+
+Attach a usageCounters to an options object and every populate() adds to
+three counters per option: given on the command line, left to its
+default, and given a value that didn't convert. The counters live in a
+file shared by all the processes using the same set of options, named
+after a hash of the option names, and are bumped with relaxed atomic adds.
+Options that weren't mentioned cost nothing.
+
+example usage :
+  ...
+
+  arguments::options<> args;
+  arguments::usageCounters<> usage;
+
+  args.option(...);
+  ...
+  usage.attach(args, "/var/lib/foo/usage");   // Before populate().
+
+  args.populate(argc, argv);
+
+Failing to open or create the file just leaves the counting off. The
+cmdusage tool (usagestats.cc) adds up the files, from many machines say,
+and lists the counts per option, and the options never used.
+
+The file is laid out as a usageHeader, one usageSlot per option index,
+then the options' names, '\0' terminated, in index order.
+
+*/
+
+#ifndef HH_CMDLINEARG_USAGE_HH
+#define HH_CMDLINEARG_USAGE_HH
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cmdlinearg.hh"
+#include "fingerprint.hh"
+
+namespace arguments {
+
+struct usageHeader
+  {
+  std::uint64_t magic, size;
+  std::uint64_t schema[2];   // hash128 of the option names.
+  std::uint64_t count;       // Options.
+  std::uint64_t parses;      // populate()s.
+  };
+
+struct usageSlot
+  {
+  std::uint64_t seen, defaulted, invalid, spare;
+  };
+
+static const std::uint64_t usageMagic = 0x31746e636772616dULL;   // "margcnt1"
+
+// The name an option is listed under.
+template<typename A>
+std::string usageName(const A* a)
+  {
+  if (a->l)
+    return std::string("--") + a->l;
+  if (a->s)
+    return std::string("-") + a->s;
+  return "(positional)";
+  }
+
+/** Check the layout of a counters file read into data, and find its parts.
+*/
+inline bool readUsage(const std::string &data, usageHeader &h,
+                      const usageSlot* &slots, std::vector<std::string> &names)
+  {
+  if (data.size() < sizeof(h))
+    return false;
+
+  std::memcpy(&h, data.data(), sizeof(h));
+
+  std::uint64_t end = sizeof(h) + h.count * sizeof(usageSlot);
+
+  if (h.magic != usageMagic || h.size != data.size() || h.count > data.size() || end > h.size)
+    return false;
+
+  slots = reinterpret_cast<const usageSlot*>(data.data() + sizeof(h));
+  names.clear();
+
+  for (const char* p = data.data() + end; names.size() < h.count; )
+    {
+    const char* z = static_cast<const char*>(std::memchr(p, '\0', data.data() + data.size() - p));
+
+    if (z == nullptr)
+      return false;
+
+    names.push_back(std::string(p, z));
+    p = z + 1;
+    }
+
+  return true;
+  }
+
+template<typename Options = options<> >
+struct usageCounters : public Options::populateObserver
+  {
+  usageHeader* head;
+  usageSlot* slots;
+  std::size_t size;
+  Options* watched;       // Whose observer we are, if any.
+
+  usageCounters() : head(nullptr), slots(nullptr), size(0), watched(nullptr) {}
+  ~usageCounters() { release(); }
+
+  usageCounters(const usageCounters&) = delete;
+  usageCounters& operator=(const usageCounters&) = delete;
+
+  // Stop counting, and unmap the counters.
+  void release()
+    {
+    if (watched && watched->observer == this)
+      watched->observer = nullptr;
+    watched = nullptr;
+
+    if (head)
+      munmap(head, size);
+    head = nullptr;
+    slots = nullptr;
+    size = 0;
+    }
+
+  /** Map (creating if need be) the counters file for args' options in
+      directory dir, and count args' populate()s from now on.
+
+      @param args  The options, all declared.
+      @param dir   Where the counter files are kept.
+  */
+  bool attach(Options &args, const std::string &dir)
+    {
+    hash128 h;
+    std::string names;
+    std::uint64_t count = args.options.empty() ? 0 : args.options.front()->index + 1;
+    std::vector<std::string> byIndex(count);
+
+    for (auto a: args.options)
+      byIndex[a->index] = usageName(a);
+
+    for (auto &n: byIndex)
+      {
+      names += n;
+      names += '\0';
+      }
+
+    h.bytes(names.data(), names.size());
+
+    std::pair<std::uint64_t, std::uint64_t> key = h.digest();
+    char file[40];
+
+    std::snprintf(file, sizeof(file), "/%016llx%016llx.usage",
+                  (unsigned long long)key.first, (unsigned long long)key.second);
+
+    usageHeader want{usageMagic, sizeof(usageHeader) + count * sizeof(usageSlot) + names.size(),
+                     {key.first, key.second}, count, 0};
+    std::string path = dir + file;
+
+    release();
+    if (!create(path, want, names) || !map(path, want))
+      return false;
+
+    watched = &args;
+    args.observer = this;
+    return true;
+    }
+
+  // Write a zeroed file under a temporary name and link it into place,
+  // so no one ever maps a half written file. Losing the race is fine.
+  static bool create(const std::string &path, const usageHeader &h, const std::string &names)
+    {
+    if (access(path.c_str(), F_OK) == 0)
+      return true;
+
+    std::string tmp = path + "." + std::to_string(getpid());
+    std::string data(sizeof(h) + h.count * sizeof(usageSlot), '\0');
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+
+    if (fd < 0)
+      return false;
+
+    std::memcpy(&data[0], &h, sizeof(h));
+    data += names;
+
+    const char* p = data.data();
+    const char* e = p + data.size();
+    ssize_t n = 0;
+
+    while (p < e && (n = write(fd, p, e - p)) > 0)
+      p += n;
+
+    close(fd);
+
+    bool ok = p == e && (link(tmp.c_str(), path.c_str()) == 0 || errno == EEXIST);
+
+    unlink(tmp.c_str());
+    return ok;
+    }
+
+  bool map(const std::string &path, const usageHeader &want)
+    {
+    int fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+    struct stat st;
+
+    if (fd < 0)
+      return false;
+
+    if (fstat(fd, &st) != 0 || (std::uint64_t)st.st_size != want.size)
+      {
+      close(fd);
+      return false;
+      }
+
+    void* m = mmap(nullptr, want.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+    if (m == MAP_FAILED)
+      return false;
+
+    head = static_cast<usageHeader*>(m);
+    slots = reinterpret_cast<usageSlot*>(head + 1);
+    size = want.size;
+
+    if (head->magic != usageMagic || head->count != want.count
+        || head->schema[0] != want.schema[0] || head->schema[1] != want.schema[1])
+      {
+      release();
+      return false;
+      }
+
+    return true;
+    }
+
+  static void bump(std::uint64_t &c)
+    {
+    __atomic_fetch_add(&c, 1, __ATOMIC_RELAXED);
+    }
+
+  virtual void populated(const Options &args)
+    {
+    if (head == nullptr)
+      return;
+
+    bump(head->parses);
+
+    for (auto a: args.options)
+      {
+      if ((std::uint64_t)a->index >= head->count)
+        continue;
+
+      usageSlot &s = slots[a->index];
+
+      if (a->given)
+        bump(s.seen);
+      else if (a->seen && a->d)
+        bump(s.defaulted);
+
+      if (a->failed)
+        bump(s.invalid);
+      }
+    }
+  };
+
+} // namespace arguments
+
+//HH_CMDLINEARG_USAGE_HH
+#endif
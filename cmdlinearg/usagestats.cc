@@ -0,0 +1,143 @@
+/**
+  @file: usagestats.cc
+
+  @brief: cmdusage, add up the option usage counter files written by
+          arguments::usageCounters (see usage.hh).
+
+Build with :
+
+  g++ -O2 -std=c++11 -o cmdusage usagestats.cc
+
+Usage :
+
+  ./cmdusage [--unused] file-or-directory...
+
+Directories are searched (not recursively) for '*.usage' files. Files for
+the same set of options, from different machines say, are summed. For
+each set it prints the number of parses and, per option, how often it was
+given, defaulted and given a bad value. With --unused only the options
+never given are listed, the candidates for pruning.
+
+*/
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "cmdlinearg.hh"
+#include "usage.hh"
+
+namespace {
+
+struct total
+  {
+  std::uint64_t parses;
+  int files;
+  std::vector<std::string> names;
+  std::vector<arguments::usageSlot> slots;
+  };
+
+bool add(const std::string &path, std::map<std::string, total> &totals)
+  {
+  std::ifstream in(path, std::ios::binary);
+  std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  arguments::usageHeader h;
+  const arguments::usageSlot* slots;
+  std::vector<std::string> names;
+  char key[33];
+
+  if (!in || !arguments::readUsage(data, h, slots, names))
+    {
+    std::cerr << "Not a usage counters file: '" << path << "'\n";
+    return false;
+    }
+
+  std::snprintf(key, sizeof(key), "%016llx%016llx",
+                (unsigned long long)h.schema[0], (unsigned long long)h.schema[1]);
+
+  total &t = totals[key];
+
+  if (t.files == 0)
+    {
+    t.names = names;
+    t.slots.assign(h.count, arguments::usageSlot{0, 0, 0, 0});
+    }
+
+  t.files++;
+  t.parses += h.parses;
+  for (std::size_t i = 0; i < h.count; ++i)
+    {
+    t.slots[i].seen += slots[i].seen;
+    t.slots[i].defaulted += slots[i].defaulted;
+    t.slots[i].invalid += slots[i].invalid;
+    }
+
+  return true;
+  }
+
+} // namespace
+
+int main(int argc, const char* argv[])
+  {
+  bool unused = false;
+  std::vector<std::string> paths;
+
+  arguments::options<> args;
+
+  args.option(unused, "u", "unused", "Only list options that were never given", nullptr );
+  args.option(paths, nullptr, nullptr, "Counter files or directories", nullptr );
+
+  if ( args.populateWithHelp(argc, argv, std::cerr,
+          "Usage:\n " + std::string(argv[0]) + " [options] file-or-directory...\n" ) )
+    return 2;
+
+  std::map<std::string, total> totals;
+  bool ok = true;
+
+  for (auto &p: paths)
+    {
+    struct stat st;
+    DIR* d;
+
+    if (stat(p.c_str(), &st) == 0 && S_ISDIR(st.st_mode) && (d = opendir(p.c_str())))
+      {
+      while (dirent* e = readdir(d))
+        {
+        std::string n(e->d_name);
+
+        if (n.size() > 6 && n.compare(n.size() - 6, 6, ".usage") == 0)
+          ok = add(p + "/" + n, totals) && ok;
+        }
+      closedir(d);
+      }
+    else
+      ok = add(p, totals) && ok;
+    }
+
+  for (auto &k: totals)
+    {
+    const total &t = k.second;
+
+    std::printf("options %s: %llu parses in %d file(s)\n", k.first.c_str(),
+                (unsigned long long)t.parses, t.files);
+    std::printf("  %-32s %12s %12s %12s\n", "option", "given", "defaulted", "invalid");
+
+    for (std::size_t i = 0; i < t.slots.size(); ++i)
+      if (!unused || t.slots[i].seen == 0)
+        std::printf("  %-32s %12llu %12llu %12llu\n", t.names[i].c_str(),
+                    (unsigned long long)t.slots[i].seen,
+                    (unsigned long long)t.slots[i].defaulted,
+                    (unsigned long long)t.slots[i].invalid);
+
+    std::printf("\n");
+    }
+
+  return ok ? 0 : 1;
+  }
@@ -0,0 +1,304 @@
+/**
+  @file: validate.cc
+
+  @brief: cmdvalidate, check a corpus of stored command lines against an
+          option schema, in parallel. Doubles as a parser throughput
+          benchmark.
+
+Build with :
+
+  g++ -O2 -std=c++17 -pthread -o cmdvalidate validate.cc
+
+Usage :
+
+  ./cmdvalidate --schema jobs.schema [-0] [-j threads] [-m max] corpus...
+
+The schema has one option per line, '#' starts a comment :
+
+  <type> <short> <long> [<default>]
+
+where type is one of int, float, bool, string or a list of them, int[],
+float[] or string[]. Use '-' for a missing short or long name. An option
+with neither takes the positional values, for example :
+
+  # jobs.schema
+  string  o  outfile   out.dat
+  int     c  count     13
+  int[]   w  w
+  bool    v  verbose
+  string[] - -
+
+The corpus holds one command line per line (or per '\0' with -0), quoted
+as in the shell (see splitWords()), without the program name. Each thread parses its share of
+the lines with its own reusable options object, collecting every error of
+each line in one pass (see populate()). The first few failures and then
+totals and throughput are printed. The exit status is 1 if any line
+failed.
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cmdlinearg.hh"
+
+namespace {
+
+struct schemaLine
+  {
+  std::string type, s, l, d;
+  bool hasDefault;
+  };
+
+bool readSchema(const std::string &path, std::vector<schemaLine> &out)
+  {
+  std::ifstream f(path);
+  std::string line;
+
+  if (!f)
+    return false;
+
+  while (std::getline(f, line))
+    {
+    std::istringstream w(line.substr(0, line.find('#')));
+    schemaLine x;
+
+    if (!(w >> x.type))
+      continue;
+
+    if (!(w >> x.s >> x.l))
+      return false;
+
+    x.hasDefault = bool(w >> x.d);
+    out.push_back(x);
+    }
+
+  return true;
+  }
+
+// One parser, with somewhere to put every value, per thread.
+struct instance
+  {
+  arguments::options<> args;
+  std::deque<int> ints;
+  std::deque<float> floats;
+  std::deque<bool> bools;
+  std::deque<std::string> strings;
+  std::deque<std::vector<int> > intLists;
+  std::deque<std::vector<float> > floatLists;
+  std::deque<std::vector<std::string> > stringLists;
+
+  static const char* name(const std::string &n)
+    {
+    return n == "-" ? nullptr : n.c_str();
+    }
+
+  template<typename T>
+  void add(std::deque<T> &d, const schemaLine &x)
+    {
+    d.push_back(T());
+    args.option(d.back(), name(x.s), name(x.l), "", x.hasDefault ? x.d.c_str() : nullptr);
+    }
+
+  bool build(const std::vector<schemaLine> &schema)
+    {
+    for (auto &x: schema)
+      if (x.type == "int")           add(ints, x);
+      else if (x.type == "float")    add(floats, x);
+      else if (x.type == "bool")     add(bools, x);
+      else if (x.type == "string")   add(strings, x);
+      else if (x.type == "int[]")    add(intLists, x);
+      else if (x.type == "float[]")  add(floatLists, x);
+      else if (x.type == "string[]") add(stringLists, x);
+      else
+        return false;
+
+    return true;
+    }
+
+  ~instance()
+    {
+    for (auto a: args.options)
+      delete a;
+    }
+  };
+
+struct failure
+  {
+  std::size_t line;
+  std::string text;
+  };
+
+struct tally
+  {
+  std::size_t lines, failed, tokens, errors[arguments::clash + 1];   // By errorstate_e.
+  std::vector<failure> failures;
+  };
+
+// Parse lines [b, e) of the corpus, splitting them in place.
+void work(const std::vector<schemaLine> &schema, std::vector<char*> &lines,
+          std::size_t b, std::size_t e, std::size_t maxFailures, tally &t)
+  {
+  instance inst;
+  std::vector<const char*> argv, words;
+  std::vector<arguments::errorState> errors;
+
+  inst.build(schema);
+  t = tally{0, 0, 0, {}, {}};
+
+  for (std::size_t i = b; i < e; ++i)
+    {
+    for (auto a: inst.args.options)
+      a->reset();
+
+    if (arguments::splitWords(lines[i], std::strlen(lines[i]), words))
+      {
+      argv.assign(1, "");
+      argv.insert(argv.end(), words.begin(), words.end());
+      inst.args.populate((int)argv.size(), argv.data(), errors);
+      }
+    else
+      errors.assign(1, arguments::errorState{arguments::invalid, "command line", "unclosed quote",
+                                             nullptr, (int)words.size()});
+
+    ++t.lines;
+    t.tokens += words.size();
+
+    if (errors.empty())
+      continue;
+
+    ++t.failed;
+    for (auto &x: errors)
+      ++t.errors[x.state];
+
+    if (t.failures.size() < maxFailures)
+      {
+      std::ostringstream o;
+
+      for (auto &x: errors)
+        o << "\n    " << x;
+      t.failures.push_back(failure{i + 1, o.str()});
+      }
+    }
+  }
+
+} // namespace
+
+int main(int argc, const char* argv[])
+  {
+  std::string schemaPath;
+  bool nul = false;
+  int threads = 0, maxFailures = 20;
+  std::vector<std::string> files;
+
+  arguments::options<> args;
+
+  args.option(schemaPath, "s", "schema", "Option schema file", nullptr );
+  args.option(nul, "0", "null", "Command lines are '\\0' separated", nullptr );
+  args.option(threads, "j", "threads", "Threads to use, 0 for all cores", "0" );
+  args.option(maxFailures, "m", "max-failures", "Failures to show", "20" );
+  args.option(files, nullptr, nullptr, "Corpus files", nullptr );
+
+  if ( args.populateWithHelp(argc, argv, std::cerr,
+          "Usage:\n " + std::string(argv[0]) + " --schema file [options] corpus...\n" ) )
+    return 2;
+
+  std::vector<schemaLine> schema;
+  instance check;
+
+  if (schemaPath.empty() || !readSchema(schemaPath, schema) || !check.build(schema))
+    {
+    std::cerr << "Can't read a schema from '" << schemaPath << "'\n";
+    return 2;
+    }
+
+  // Read the whole corpus and cut it into lines.
+  std::string corpus;
+  char sep = nul ? '\0' : '\n';
+
+  for (auto &f: files)
+    {
+    std::ifstream in(f, std::ios::binary);
+
+    if (!in)
+      {
+      std::cerr << "Can't read '" << f << "'\n";
+      return 2;
+      }
+
+    corpus.append(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    if (!corpus.empty() && corpus.back() != sep)
+      corpus.push_back(sep);
+    }
+
+  std::vector<char*> lines;
+  char* p = &corpus[0];
+  char* end = p + corpus.size();
+
+  while (p < end)
+    {
+    char* q = std::find(p, end, sep);
+
+    *q = '\0';
+    lines.push_back(p);
+    p = q + 1;
+    }
+
+  if (threads <= 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  // Parse in parallel, a contiguous share of lines each.
+  std::vector<tally> tallies(threads);
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < threads; ++i)
+    workers.emplace_back(work, std::cref(schema), std::ref(lines),
+                         lines.size() * i / threads, lines.size() * (i + 1) / threads,
+                         (std::size_t)maxFailures, std::ref(tallies[i]));
+
+  for (auto &w: workers)
+    w.join();
+
+  std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+
+  // Tallies are in line order, so failures come out in order too.
+  tally all{0, 0, 0, {}, {}};
+
+  for (auto &t: tallies)
+    {
+    all.lines += t.lines;
+    all.failed += t.failed;
+    all.tokens += t.tokens;
+    for (int k = 0; k <= arguments::clash; ++k)
+      all.errors[k] += t.errors[k];
+    for (auto &f: t.failures)
+      if (all.failures.size() < (std::size_t)maxFailures)
+        all.failures.push_back(f);
+    }
+
+  for (auto &f: all.failures)
+    std::cout << "line " << f.line << ":" << f.text << "\n";
+
+  std::cout << "lines:   " << all.lines << " (" << all.failed << " failed)\n"
+            << "errors:  " << all.errors[arguments::unknown] << " unknown, "
+                           << all.errors[arguments::invalid] << " invalid, "
+                           << all.errors[arguments::missing] << " missing, "
+                           << all.errors[arguments::clash] << " clash\n"
+            << "tokens:  " << all.tokens << "\n"
+            << "threads: " << threads << "\n"
+            << "time:    " << took.count() << " s, "
+            << (all.lines / took.count()) << " lines/s, "
+            << (corpus.size() / took.count() / 1e6) << " MB/s\n";
+
+  return all.failed ? 1 : 0;
+  }